@@ -613,6 +613,10 @@ Server url not configured.</translation>
         <source>removeAllEntriesDescription</source>
         <translation>Are you sure you want to clean this history?</translation>
     </message>
+    <message>
+        <source>searchMessagesPlaceholder</source>
+        <translation>Search in messages</translation>
+    </message>
 </context>
 <context>
     <name>CreateLinphoneSipAccount</name>
@@ -613,6 +613,10 @@ Url du serveur non configurée.</translation>
         <source>removeAllEntriesDescription</source>
         <translation>Êtes-vous sûr de vouloir supprimer cet historique ?</translation>
     </message>
+    <message>
+        <source>searchMessagesPlaceholder</source>
+        <translation>Rechercher dans les messages</translation>
+    </message>
 </context>
 <context>
     <name>CreateLinphoneSipAccount</name>
@@ -201,14 +201,20 @@ void App::initContentApp () {
   // Enable notifications.
   mNotifier = new Notifier(mEngine);
 
-  // Load splashscreen.
+  // Load splashscreen. Or display the timeline of the last session in the main window.
   bool selfTest = mParser->isSet("self-test");
+  bool showSnapshot = false;
   if (!selfTest) {
     #ifdef Q_OS_MACOS
-      ::activeSplashScreen(mEngine);
-    #else
-      if (!mParser->isSet("iconified"))
+      showSnapshot = TimelineSnapshot::exists();
+      if (!showSnapshot)
         ::activeSplashScreen(mEngine);
+    #else
+      if (!mParser->isSet("iconified")) {
+        showSnapshot = TimelineSnapshot::exists();
+        if (!showSnapshot)
+          ::activeSplashScreen(mEngine);
+      }
     #endif // ifdef Q_OS_MACOS
   } else
     // Set a self test limit.
@@ -222,6 +228,9 @@ void App::initContentApp () {
   if (mEngine->rootObjects().isEmpty())
     qFatal("Unable to open main window.");
 
+  if (showSnapshot)
+    smartShowWindow(getMainWindow());
+
   QObject::connect(
     CoreManager::getInstance()->getHandlers().get(),
     &CoreHandlers::coreStarted,
@@ -373,6 +382,7 @@ void App::registerTypes () {
   registerType<Camera>("Camera");
   registerType<CameraPreview>("CameraPreview");
   registerType<ChatProxyModel>("ChatProxyModel");
+  registerType<ChatSearchModel>("ChatSearchModel");
   registerType<ConferenceHelperModel>("ConferenceHelperModel");
   registerType<ConferenceModel>("ConferenceModel");
   registerType<ContactsListProxyModel>("ContactsListProxyModel");
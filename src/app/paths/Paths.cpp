@@ -44,8 +44,12 @@
 #define PATH_CONFIG "/linphonerc"
 #define PATH_FACTORY_CONFIG "/linphone/linphonerc-factory"
 #define PATH_ROOT_CA "/linphone/rootca.pem"
+#define PATH_TIMELINE_SNAPSHOT "/timeline-snapshot.db"
+#define PATH_TIMELINE_SUMMARY "/timeline-summary.db"
 #define PATH_FRIENDS_LIST "/friends.db"
 #define PATH_MESSAGE_HISTORY_LIST "/message-history.db"
+#define PATH_MESSAGE_SEARCH_CONTENTS "/message-search-contents.db"
+#define PATH_MESSAGE_SEARCH_INDEX "/message-search-index.db"
 #define PATH_ZRTP_SECRETS "/zidcache"
 
 using namespace std;
@@ -155,6 +159,22 @@ inline QString getAppMessageHistoryFilePath () {
   return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_MESSAGE_HISTORY_LIST;
 }
 
+inline QString getAppMessageSearchContentsFilePath () {
+  return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_MESSAGE_SEARCH_CONTENTS;
+}
+
+inline QString getAppMessageSearchIndexFilePath () {
+  return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_MESSAGE_SEARCH_INDEX;
+}
+
+inline QString getAppTimelineSnapshotFilePath () {
+  return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_TIMELINE_SNAPSHOT;
+}
+
+inline QString getAppTimelineSummaryFilePath () {
+  return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_TIMELINE_SUMMARY;
+}
+
 // -----------------------------------------------------------------------------
 
 bool Paths::filePathExists (const string &path) {
@@ -207,6 +227,14 @@ string Paths::getMessageHistoryFilePath () {
   return ::getWritableFilePath(::getAppMessageHistoryFilePath());
 }
 
+string Paths::getMessageSearchContentsFilePath () {
+  return ::getWritableFilePath(::getAppMessageSearchContentsFilePath());
+}
+
+string Paths::getMessageSearchIndexFilePath () {
+  return ::getWritableFilePath(::getAppMessageSearchIndexFilePath());
+}
+
 string Paths::getPackageDataDirPath () {
   return ::getReadableDirPath(::getAppPackageDataDirPath());
 }
@@ -227,6 +255,14 @@ string Paths::getThumbnailsDirPath () {
   return ::getWritableDirPath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_THUMBNAILS);
 }
 
+string Paths::getTimelineSnapshotFilePath () {
+  return ::getWritableFilePath(::getAppTimelineSnapshotFilePath());
+}
+
+string Paths::getTimelineSummaryFilePath () {
+  return ::getWritableFilePath(::getAppTimelineSummaryFilePath());
+}
+
 string Paths::getUserCertificatesDirPath () {
   return ::getWritableDirPath(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + PATH_USER_CERTIFICATES);
 }
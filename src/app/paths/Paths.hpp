@@ -40,11 +40,15 @@ namespace Paths {
   std::string getDownloadDirPath ();
   std::string getLogsDirPath ();
   std::string getMessageHistoryFilePath ();
+  std::string getMessageSearchContentsFilePath ();
+  std::string getMessageSearchIndexFilePath ();
   std::string getPackageDataDirPath ();
   std::string getPackageMsPluginsDirPath ();
   std::string getPluginsDirPath ();
   std::string getRootCaFilePath ();
   std::string getThumbnailsDirPath ();
+  std::string getTimelineSnapshotFilePath ();
+  std::string getTimelineSummaryFilePath ();
   std::string getUserCertificatesDirPath ();
   std::string getZrtpDataFilePath ();
   std::string getZrtpSecretsFilePath ();
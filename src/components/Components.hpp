@@ -30,6 +30,7 @@
 #include "camera/Camera.hpp"
 #include "camera/CameraPreview.hpp"
 #include "chat/ChatProxyModel.hpp"
+#include "chat/ChatSearchModel.hpp"
 #include "codecs/AudioCodecsModel.hpp"
 #include "codecs/VideoCodecsModel.hpp"
 #include "conference/ConferenceAddModel.hpp"
@@ -42,6 +43,7 @@
 #include "sound-player/SoundPlayer.hpp"
 #include "telephone-numbers/TelephoneNumbersModel.hpp"
 #include "timeline/TimelineModel.hpp"
+#include "timeline/TimelineSnapshot.hpp"
 #include "url-handlers/UrlHandlers.hpp"
 
 #include "other/colors/Colors.hpp"
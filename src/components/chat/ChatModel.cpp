@@ -21,27 +21,39 @@
  */
 
 #include <algorithm>
+#include <iterator>
+#include <limits>
 
 #include <QDateTime>
 #include <QDesktopServices>
 #include <QFileInfo>
 #include <QTimer>
-#include <QUuid>
 
 #include "../../app/App.hpp"
 #include "../../app/paths/Paths.hpp"
 #include "../../app/providers/ThumbnailProvider.hpp"
 #include "../../utils/Utils.hpp"
-#include "../../utils/QExifImageHeader.h"
 #include "../core/CoreManager.hpp"
 
+#include "FileTransferScheduler.hpp"
+#include "ThumbnailGenerator.hpp"
+
 #include "ChatModel.hpp"
 
-#define THUMBNAIL_IMAGE_FILE_HEIGHT 100
-#define THUMBNAIL_IMAGE_FILE_WIDTH 100
+// Number of messages fetched from the database per history page.
+#define HISTORY_PAGE_SIZE 100
+
+// Max interval between two signaled file transfer progress changes. (~60 Hz)
+#define FILE_TRANSFER_PROGRESS_INTERVAL 16
+
+// Min interval between two file transfer speed samples.
+#define FILE_TRANSFER_SPEED_INTERVAL 250
+
+// In Bytes. Uploaded files are streamed, they are never loaded in memory.
+#define FILE_SIZE_LIMIT Q_INT64_C(4294967296)
 
-// In Bytes.
-#define FILE_SIZE_LIMIT 524288000
+// Number of call logs removed per event loop iteration.
+#define CALL_LOGS_REMOVAL_CHUNK_SIZE 50
 
 using namespace std;
 
@@ -51,6 +63,7 @@ inline QString getFileId (const shared_ptr<linphone::ChatMessage> &message) {
   return ::Utils::coreStringToAppString(message->getAppdata()).section(':', 0, 0);
 }
 
+// Download path of received files or source path of sent files.
 inline QString getDownloadPath (const shared_ptr<linphone::ChatMessage> &message) {
   return ::Utils::coreStringToAppString(message->getAppdata()).section(':', 1);
 }
@@ -60,74 +73,77 @@ inline bool fileWasDownloaded (const shared_ptr<linphone::ChatMessage> &message)
   return !path.isEmpty() && QFileInfo(path).isFile();
 }
 
-inline void fillThumbnailProperty (QVariantMap &dest, const shared_ptr<linphone::ChatMessage> &message) {
+inline void fillThumbnailProperty (QString &dest, const shared_ptr<linphone::ChatMessage> &message) {
   QString fileId = ::getFileId(message);
-  if (!fileId.isEmpty() && !dest.contains("thumbnail"))
-    dest["thumbnail"] = QStringLiteral("image://%1/%2")
+  if (!fileId.isEmpty() && dest.isEmpty())
+    dest = QStringLiteral("image://%1/%2")
       .arg(ThumbnailProvider::PROVIDER_ID).arg(fileId);
 }
 
-inline void createThumbnail (const shared_ptr<linphone::ChatMessage> &message) {
-  if (!message->getAppdata().empty())
-    return;
-
-  QString thumbnailPath = ::Utils::coreStringToAppString(message->getFileTransferFilepath());
-  QImage image(thumbnailPath);
-  if (image.isNull())
-    return;
+inline void removeFileMessageThumbnail (const shared_ptr<linphone::ChatMessage> &message) {
+  if (message && message->getFileTransferInformation()) {
+    FileTransferScheduler::getInstance()->cancel(message);
+    message->cancelFileTransfer();
 
-  int rotation = 0;
-  QExifImageHeader exifImageHeader;
-  if (exifImageHeader.loadFromJpeg(thumbnailPath)) {
-    rotation = (int) exifImageHeader.value(QExifImageHeader::ImageTag::Orientation).toShort();
+    ThumbnailGenerator::getInstance()->unref(::getFileId(message));
   }
+}
 
-  QImage thumbnail = image.scaled(
-    THUMBNAIL_IMAGE_FILE_WIDTH, THUMBNAIL_IMAGE_FILE_HEIGHT,
-    Qt::KeepAspectRatio, Qt::SmoothTransformation
-  );
-
-  if (rotation != 0) {
-    QTransform transform;
-    if (rotation == 3 || rotation == 4) {
-      transform.rotate(180);
-    } else if (rotation == 5 || rotation == 6) {
-      transform.rotate(90);
-    } else if (rotation == 7 || rotation == 8) {
-      transform.rotate(-90);
-    }
-    thumbnail = thumbnail.transformed(transform);
-    if (rotation == 2 || rotation == 4 || rotation == 5 || rotation == 7) {
-      thumbnail = thumbnail.mirrored(true, false);
+// Release the thumbnails of the messages which are not loaded, from the `begin` offset to the oldest one.
+// Only the file ids are kept, the messages are read by pages.
+inline void unrefHistoryThumbnails (const shared_ptr<linphone::ChatRoom> &chatRoom, int begin) {
+  QStringList fileIds;
+  const int historySize = chatRoom->getHistorySize();
+  for (int offset = begin; offset < historySize; offset += HISTORY_PAGE_SIZE)
+    for (const auto &message : chatRoom->getHistoryRange(offset, offset + HISTORY_PAGE_SIZE - 1)) {
+      const QString fileId = ::getFileId(message);
+      if (!fileId.isEmpty())
+        fileIds << fileId;
     }
-  }
 
-  QString uuid = QUuid::createUuid().toString();
-  QString fileId = QStringLiteral("%1.jpg").arg(uuid.mid(1, uuid.length() - 2));
+  ThumbnailGenerator *thumbnailGenerator = ThumbnailGenerator::getInstance();
+  for (const QString &fileId : fileIds)
+    thumbnailGenerator->unref(fileId);
+}
 
-  if (!thumbnail.save(::Utils::coreStringToAppString(Paths::getThumbnailsDirPath()) + fileId, "jpg", 100)) {
-    qWarning() << QStringLiteral("Unable to create thumbnail of: `%1`.").arg(thumbnailPath);
-    return;
+// Remove call logs by chunks in the main loop. The chat model can be destroyed before the end.
+inline void removeCallLogsByChunks (const shared_ptr<list<shared_ptr<linphone::CallLog> > > &callLogs) {
+  shared_ptr<linphone::Core> core = CoreManager::getInstance()->getCore();
+  for (int n = 0; n < CALL_LOGS_REMOVAL_CHUNK_SIZE && !callLogs->empty(); ++n) {
+    core->removeCallLog(callLogs->front());
+    callLogs->pop_front();
   }
 
-  message->setAppdata(::Utils::appStringToCoreString(fileId));
+  if (!callLogs->empty())
+    QTimer::singleShot(0, CoreManager::getInstance(), [callLogs] {
+      ::removeCallLogsByChunks(callLogs);
+    });
 }
 
-inline void removeFileMessageThumbnail (const shared_ptr<linphone::ChatMessage> &message) {
-  if (message && message->getFileTransferInformation()) {
-    message->cancelFileTransfer();
+inline void removeCallLogs (list<shared_ptr<linphone::CallLog> > &callLogs) {
+  if (callLogs.empty())
+    return;
 
-    string fileId = message->getAppdata();
-    if (!fileId.empty()) {
-      QString thumbnailPath = ::Utils::coreStringToAppString(Paths::getThumbnailsDirPath() + fileId);
-      if (!QFile::remove(thumbnailPath))
-        qWarning() << QStringLiteral("Unable to remove `%1`.").arg(thumbnailPath);
-    }
-  }
+  // Start and end entries share the same call log.
+  callLogs.sort();
+  callLogs.unique();
+
+  ::removeCallLogsByChunks(make_shared<list<shared_ptr<linphone::CallLog> > >(move(callLogs)));
 }
 
 // -----------------------------------------------------------------------------
 
+// Source of a file message being uploaded. The chunks are served from a mapping of the file.
+struct FileUpload {
+  ~FileUpload () {
+    if (data)
+      file.unmap(data);
+  }
+
+  QFile file;
+  uchar *data = nullptr; // Null if the file can't be mapped, chunks are read in this case.
+};
+
 class ChatModel::MessageHandlers : public linphone::ChatMessageListener {
   friend class ChatModel;
 
@@ -137,25 +153,63 @@ public:
   ~MessageHandlers () = default;
 
 private:
-  QList<ChatEntryData>::iterator findMessageEntry (const shared_ptr<linphone::ChatMessage> &message) {
-    return find_if(mChatModel->mEntries.begin(), mChatModel->mEntries.end(), [&message](const ChatEntryData &pair) {
-        return pair.second == message;
-      });
+  void signalDataChanged (int row) {
+    emit mChatModel->dataChanged(mChatModel->index(row, 0), mChatModel->index(row, 0));
   }
 
-  void signalDataChanged (const QList<ChatEntryData>::iterator &it) {
-    int row = static_cast<int>(distance(mChatModel->mEntries.begin(), it));
-    emit mChatModel->dataChanged(mChatModel->index(row, 0), mChatModel->index(row, 0));
+  shared_ptr<FileUpload> getFileUpload (const shared_ptr<linphone::ChatMessage> &message) {
+    shared_ptr<FileUpload> &upload = mFileUploads[message.get()];
+    if (upload)
+      return upload;
+
+    upload = make_shared<FileUpload>();
+    upload->file.setFileName(::getDownloadPath(message));
+    if (!upload->file.open(QIODevice::ReadOnly)) {
+      qWarning() << QStringLiteral("Unable to open file to upload: `%1`.").arg(upload->file.fileName());
+      mFileUploads.remove(message.get());
+      return nullptr;
+    }
+
+    upload->data = upload->file.map(0, upload->file.size());
+    if (!upload->data)
+      qWarning() << QStringLiteral("Unable to map file to upload: `%1`.").arg(upload->file.fileName());
+
+    return upload;
+  }
+
+  void removeFileUpload (const shared_ptr<linphone::ChatMessage> &message) {
+    mFileUploads.remove(message.get());
   }
 
   shared_ptr<linphone::Buffer> onFileTransferSend (
-    const shared_ptr<linphone::ChatMessage> &,
+    const shared_ptr<linphone::ChatMessage> &message,
     const shared_ptr<const linphone::Content> &,
-    size_t,
-    size_t
+    size_t offset,
+    size_t size
   ) override {
-    qWarning() << "`onFileTransferSend` called.";
-    return nullptr;
+    // The source file was removed or moved, an empty buffer would end the transfer as a success.
+    shared_ptr<FileUpload> upload = getFileUpload(message);
+    if (!upload) {
+      message->cancelFileTransfer();
+      return nullptr;
+    }
+
+    const qint64 fileSize = upload->file.size();
+    const qint64 start = qMin(static_cast<qint64>(offset), fileSize);
+    const qint64 count = qMin(static_cast<qint64>(size), fileSize - start);
+
+    const uint8_t *chunk;
+    QByteArray readChunk;
+    if (upload->data)
+      chunk = upload->data + start;
+    else {
+      upload->file.seek(start);
+      readChunk = upload->file.read(count);
+      chunk = reinterpret_cast<const uint8_t *>(readChunk.constData());
+    }
+
+    // An empty buffer ends the transfer.
+    return linphone::Buffer::newFromData(chunk, static_cast<size_t>(count));
   }
 
   void onFileTransferProgressIndication (
@@ -164,45 +218,63 @@ private:
     size_t offset,
     size_t
   ) override {
-    if (!mChatModel)
-      return;
+    FileTransferScheduler::getInstance()->handleFileTransferProgress(message, offset);
 
-    auto it = findMessageEntry(message);
-    if (it == mChatModel->mEntries.end())
+    if (!mChatModel)
       return;
 
-    (*it).first["fileOffset"] = static_cast<quint64>(offset);
-
-    signalDataChanged(it);
+    int row = mChatModel->findMessageRow(message);
+    if (row != -1)
+      mChatModel->updateFileTransferProgress(row, static_cast<quint64>(offset));
   }
 
   void onMsgStateChanged (const shared_ptr<linphone::ChatMessage> &message, linphone::ChatMessageState state) override {
-    if (!mChatModel)
-      return;
-
-    auto it = findMessageEntry(message);
-    if (it == mChatModel->mEntries.end())
-      return;
-
-    // File message downloaded.
-    if (state == linphone::ChatMessageStateFileTransferDone && !message->isOutgoing()) {
-      ::createThumbnail(message);
-      ::fillThumbnailProperty((*it).first, message);
+    // Uploads continue even if the chat model is destroyed.
+    if (state != linphone::ChatMessageStateInProgress) {
+      removeFileUpload(message);
+      FileTransferScheduler::getInstance()->handleFileTransferEnded(message);
+    }
 
+    // File message downloaded. The path is kept even if the chat model is destroyed.
+    const bool fileDownloaded = state == linphone::ChatMessageStateFileTransferDone && !message->isOutgoing();
+    if (fileDownloaded) {
       message->setAppdata(
         ::Utils::appStringToCoreString(::getFileId(message)) + ':' + message->getFileTransferFilepath()
       );
-      (*it).first["wasDownloaded"] = true;
+
+      if (::getFileId(message).isEmpty()) {
+        if (mChatModel)
+          mChatModel->requestThumbnail(message);
+        else
+          ThumbnailGenerator::getInstance()->generate(message, ::getDownloadPath(message));
+      }
 
       App::getInstance()->getNotifier()->notifyReceivedFileMessage(message);
     }
 
-    (*it).first["status"] = state;
+    if (!mChatModel)
+      return;
+
+    int row = mChatModel->findMessageRow(message);
+    if (row == -1)
+      return;
+
+    ChatEntryData &entry = mChatModel->mEntries[row];
+    if (fileDownloaded)
+      entry.wasDownloaded = true;
 
-    signalDataChanged(it);
+    entry.status = state;
+
+    if (state != linphone::ChatMessageStateInProgress)
+      mChatModel->removeFileTransferStats(message.get());
+
+    signalDataChanged(row);
   }
 
   ChatModel *mChatModel;
+
+  // Message => upload, shared by all the file messages of the chat room.
+  QHash<const void *, shared_ptr<FileUpload> > mFileUploads;
 };
 
 // -----------------------------------------------------------------------------
@@ -213,6 +285,20 @@ ChatModel::ChatModel (const QString &sipAddress) {
   mCoreHandlers = core->getHandlers();
   mMessageHandlers = make_shared<MessageHandlers>(this);
 
+  QObject::connect(
+    ThumbnailGenerator::getInstance(), &ThumbnailGenerator::thumbnailGenerated,
+    this, &ChatModel::handleThumbnailGenerated
+  );
+  QObject::connect(
+    FileTransferScheduler::getInstance(), &FileTransferScheduler::queuedChanged,
+    this, &ChatModel::handleFileQueuedChanged
+  );
+
+  mFileTransferProgressTimer = new QTimer(this);
+  mFileTransferProgressTimer->setInterval(FILE_TRANSFER_PROGRESS_INTERVAL);
+  mFileTransferProgressTimer->setSingleShot(true);
+  QObject::connect(mFileTransferProgressTimer, &QTimer::timeout, this, &ChatModel::signalFileTransferProgress);
+
   setSipAddress(sipAddress);
 
   {
@@ -227,10 +313,31 @@ ChatModel::~ChatModel () {
   mMessageHandlers->mChatModel = nullptr;
 }
 
+shared_ptr<linphone::ChatMessageListener> ChatModel::getDetachedMessageHandlers () {
+  static shared_ptr<MessageHandlers> messageHandlers = make_shared<MessageHandlers>(nullptr);
+  return messageHandlers;
+}
+
 QHash<int, QByteArray> ChatModel::roleNames () const {
   QHash<int, QByteArray> roles;
   roles[Roles::ChatEntry] = "$chatEntry";
   roles[Roles::SectionDate] = "$sectionDate";
+
+  roles[Roles::Type] = "$type";
+  roles[Roles::Timestamp] = "$timestamp";
+  roles[Roles::Content] = "$content";
+  roles[Roles::IsOutgoing] = "$isOutgoing";
+  roles[Roles::IsStart] = "$isStart";
+  roles[Roles::Status] = "$status";
+  roles[Roles::FileName] = "$fileName";
+  roles[Roles::FileSize] = "$fileSize";
+  roles[Roles::FileOffset] = "$fileOffset";
+  roles[Roles::WasDownloaded] = "$wasDownloaded";
+  roles[Roles::Thumbnail] = "$thumbnail";
+  roles[Roles::FileSpeed] = "$fileSpeed";
+  roles[Roles::FileEta] = "$fileEta";
+  roles[Roles::IsFileQueued] = "$isFileQueued";
+
   return roles;
 }
 
@@ -244,16 +351,85 @@ QVariant ChatModel::data (const QModelIndex &index, int role) const {
   if (!index.isValid() || row < 0 || row >= mEntries.count())
     return QVariant();
 
+  const ChatEntryData &entry = mEntries[row];
+
   switch (role) {
     case Roles::ChatEntry:
-      return QVariant::fromValue(mEntries[row].first);
+      return toVariantMap(entry);
     case Roles::SectionDate:
-      return QVariant::fromValue(mEntries[row].first["timestamp"].toDate());
+      return QDateTime::fromMSecsSinceEpoch(entry.timestamp).date();
+
+    case Roles::Type:
+      return entry.type;
+    case Roles::Timestamp:
+      return QDateTime::fromMSecsSinceEpoch(entry.timestamp);
+    case Roles::Content:
+      return entry.content;
+    case Roles::IsOutgoing:
+      return entry.isOutgoing;
+    case Roles::IsStart:
+      return entry.isStart;
+    case Roles::Status:
+      return entry.status;
+    case Roles::FileName:
+      return entry.fileName;
+    case Roles::FileSize:
+      return entry.fileSize;
+    case Roles::FileOffset:
+      return entry.fileOffset;
+    case Roles::WasDownloaded:
+      return entry.wasDownloaded;
+    case Roles::Thumbnail:
+      return entry.thumbnail;
+
+    case Roles::FileSpeed:
+    case Roles::FileEta: {
+      auto it = mFileTransferStats.constFind(entry.linphonePtr.get());
+      double speed = it == mFileTransferStats.cend() ? 0 : it->speed;
+      if (role == Roles::FileSpeed)
+        return static_cast<quint64>(speed);
+      return speed >= 1 && entry.fileSize > entry.fileOffset
+        ? static_cast<int>((entry.fileSize - entry.fileOffset) / speed)
+        : -1;
+    }
+
+    case Roles::IsFileQueued:
+      return entry.isFile && FileTransferScheduler::getInstance()->isQueued(
+        static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr)
+      );
   }
 
   return QVariant();
 }
 
+QVariantMap ChatModel::toVariantMap (const ChatEntryData &entry) const {
+  QVariantMap map;
+
+  map["type"] = entry.type;
+  map["timestamp"] = QDateTime::fromMSecsSinceEpoch(entry.timestamp);
+  map["isOutgoing"] = entry.isOutgoing;
+  map["status"] = entry.status;
+
+  if (entry.type == EntryType::CallEntry) {
+    map["isStart"] = entry.isStart;
+    return map;
+  }
+
+  map["content"] = entry.content;
+
+  if (entry.isFile) {
+    map["fileSize"] = entry.fileSize;
+    map["fileOffset"] = entry.fileOffset;
+    map["fileName"] = entry.fileName;
+    map["wasDownloaded"] = entry.wasDownloaded;
+
+    if (!entry.thumbnail.isEmpty())
+      map["thumbnail"] = entry.thumbnail;
+  }
+
+  return map;
+}
+
 bool ChatModel::removeRow (int row, const QModelIndex &) {
   return removeRows(row, 1);
 }
@@ -264,16 +440,28 @@ bool ChatModel::removeRows (int row, int count, const QModelIndex &parent) {
   if (row < 0 || count < 0 || limit >= mEntries.count())
     return false;
 
+  list<shared_ptr<linphone::CallLog> > callLogs;
+
   beginRemoveRows(parent, row, limit);
 
-  for (int i = 0; i < count; ++i) {
-    removeEntry(mEntries[row]);
-    mEntries.removeAt(row);
-  }
+  unindexRows(row, limit);
+
+  for (int i = row; i <= limit; ++i)
+    removeEntry(mEntries[i], callLogs);
+  mEntries.erase(mEntries.begin() + row, mEntries.begin() + limit + 1);
+
+  shiftRowIndex(row, -count);
 
   endRemoveRows();
 
-  if (mEntries.count() == 0)
+  if (!callLogs.empty()) {
+    removeSymmetricCallEntries(callLogs);
+    emit callLogsRemoved(callLogs);
+    ::removeCallLogs(callLogs);
+  }
+
+  // Entries which are not loaded can remain.
+  if (mEntries.count() == 0 && !canLoadMoreEntries())
     emit allEntriesRemoved();
 
   return true;
@@ -293,27 +481,158 @@ void ChatModel::setSipAddress (const QString &sipAddress) {
 
   handleIsComposingChanged(mChatRoom);
 
-  // Get messages.
-  for (auto &message : mChatRoom->getHistory(0)) {
-    QVariantMap map;
+  // Get calls. They are displayed page by page with the messages.
+  for (auto &callLog : core->getCallHistoryForAddress(mChatRoom->getPeerAddress()))
+    mPendingCallLogs.push_back(callLog);
+
+  mPendingCallLogs.sort([](const shared_ptr<linphone::CallLog> &a, const shared_ptr<linphone::CallLog> &b) {
+    return a->getStartDate() < b->getStartDate();
+  });
+
+  // Get the last messages.
+  loadMoreEntries();
+}
+
+bool ChatModel::getIsRemoteComposing () const {
+  return mIsRemoteComposing;
+}
+
+// -----------------------------------------------------------------------------
+
+int ChatModel::loadMoreEntries () {
+  QList<ChatEntryData> messageEntries;
+
+  // 1. Get an older page of messages. (From the oldest to the newest.)
+  int historySize = mChatRoom->getHistorySize();
+  time_t threshold = 0;
+
+  if (mLoadedMessagesCount < historySize) {
+    list<shared_ptr<linphone::ChatMessage> > messages = mChatRoom->getHistoryRange(
+      mLoadedMessagesCount, mLoadedMessagesCount + HISTORY_PAGE_SIZE - 1
+    );
+    mLoadedMessagesCount += static_cast<int>(messages.size());
+
+    for (auto &message : messages) {
+      ChatEntryData entry;
 
-    fillMessageEntry(map, message);
+      fillMessageEntry(entry, message);
 
-    // Old workaround.
-    // It can exist messages with a not delivered status. It's a linphone core bug.
-    if (message->getState() == linphone::ChatMessageStateInProgress)
-      map["status"] = linphone::ChatMessageStateNotDelivered;
+      // Old workaround.
+      // It can exist messages with a not delivered status. It's a linphone core bug.
+      if (message->getState() == linphone::ChatMessageStateInProgress)
+        entry.status = linphone::ChatMessageStateNotDelivered;
+
+      messageEntries << entry;
+    }
 
-    mEntries << qMakePair(map, static_pointer_cast<void>(message));
+    // Older messages exist, keep older calls for the next pages.
+    if (mLoadedMessagesCount < historySize && !messages.empty())
+      threshold = messages.front()->getTime();
   }
 
-  // Get calls.
-  for (auto &callLog : core->getCallHistoryForAddress(mChatRoom->getPeerAddress()))
-    insertCall(callLog);
+  // 2. Get the calls of the same period. Without older messages, calls are paginated too.
+  // Starts are taken from the newest to the oldest, ends are not ordered. (Call durations.)
+  QList<ChatEntryData> callStartEntries;
+  QList<ChatEntryData> callEndEntries;
+
+  for (int n = 0; !mPendingCallLogs.empty(); ++n) {
+    shared_ptr<linphone::CallLog> callLog = mPendingCallLogs.back();
+    if (threshold ? callLog->getStartDate() < threshold : n >= HISTORY_PAGE_SIZE)
+      break;
+
+    mPendingCallLogs.pop_back();
+
+    linphone::CallStatus status = callLog->getStatus();
+    if (status == linphone::CallStatusAborted || status == linphone::CallStatusEarlyAborted)
+      continue; // Ignore aborted calls.
+
+    ChatEntryData start;
+    fillCallStartEntry(start, callLog);
+    callStartEntries.prepend(start);
+
+    if (status == linphone::CallStatusSuccess) {
+      ChatEntryData end;
+      fillCallEndEntry(end, callLog);
+      callEndEntries << end;
+    }
+  }
+
+  int count = messageEntries.count() + callStartEntries.count() + callEndEntries.count();
+  if (!count)
+    return 0;
+
+  // 3. Merge the sorted sources.
+  auto lessThan = [](const ChatEntryData &a, const ChatEntryData &b) {
+    return a.timestamp < b.timestamp;
+  };
+
+  stable_sort(callEndEntries.begin(), callEndEntries.end(), lessThan);
+
+  QList<ChatEntryData> callEntries;
+  callEntries.reserve(callStartEntries.count() + callEndEntries.count());
+  merge(
+    callStartEntries.cbegin(), callStartEntries.cend(),
+    callEndEntries.cbegin(), callEndEntries.cend(),
+    back_inserter(callEntries), lessThan
+  );
+
+  QList<ChatEntryData> entries;
+  entries.reserve(count);
+  merge(
+    messageEntries.cbegin(), messageEntries.cend(),
+    callEntries.cbegin(), callEntries.cend(),
+    back_inserter(entries), lessThan
+  );
+
+  // 4. First page, publish all entries at once.
+  if (mEntries.isEmpty()) {
+    beginResetModel();
+    mEntries = entries;
+    mRowIndex.clear();
+    mRowIndexShift = 0;
+    indexRows(0, count - 1);
+    endResetModel();
+
+    return count;
+  }
+
+  // 5. Entries more recent than the first displayed entry (the end of a long call for example)
+  // must be inserted at the right place.
+  const qint64 first = mEntries.first().timestamp;
+  while (!entries.isEmpty() && entries.last().timestamp > first)
+    insertEntry(entries.takeLast());
+
+  // 6. Prepend the others.
+  if (!entries.isEmpty()) {
+    beginInsertRows(QModelIndex(), 0, entries.count() - 1);
+    shiftRowIndex(0, entries.count());
+    for (auto it = entries.crbegin(); it != entries.crend(); ++it)
+      mEntries.prepend(*it);
+    indexRows(0, entries.count() - 1);
+    endInsertRows();
+  }
+
+  return count;
 }
 
-bool ChatModel::getIsRemoteComposing () const {
-  return mIsRemoteComposing;
+bool ChatModel::canLoadMoreEntries () const {
+  return mLoadedMessagesCount < mChatRoom->getHistorySize() || !mPendingCallLogs.empty();
+}
+
+int ChatModel::findMessageEntry (qint64 timestamp, const QString &content) {
+  // Messages of the same second can be on the previous page.
+  while ((mEntries.isEmpty() || mEntries.first().timestamp >= timestamp) && canLoadMoreEntries())
+    loadMoreEntries();
+
+  auto it = lower_bound(mEntries.begin(), mEntries.end(), timestamp, [](const ChatEntryData &entry, qint64 timestamp) {
+    return entry.timestamp < timestamp;
+  });
+
+  for (; it != mEntries.end() && it->timestamp == timestamp; ++it)
+    if (it->type == EntryType::MessageEntry && (it->content == content || it->fileName == content))
+      return static_cast<int>(distance(mEntries.begin(), it));
+
+  return -1;
 }
 
 // -----------------------------------------------------------------------------
@@ -329,15 +648,43 @@ void ChatModel::removeEntry (int id) {
 void ChatModel::removeAllEntries () {
   qInfo() << QStringLiteral("Removing all chat entries of: %1.").arg(getSipAddress());
 
+  list<shared_ptr<linphone::CallLog> > callLogs;
+
   beginResetModel();
 
-  for (auto &entry : mEntries)
-    removeEntry(entry);
+  // The messages are removed with the history, only release their files here.
+  for (auto &entry : mEntries) {
+    if (entry.type == EntryType::MessageEntry) {
+      shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
+      ::removeFileMessageThumbnail(message);
+      cancelThumbnail(message);
+    } else if (entry.type == EntryType::CallEntry)
+      callLogs.push_back(static_pointer_cast<linphone::CallLog>(entry.linphonePtr));
+  }
 
   mEntries.clear();
+  mRowIndex.clear();
+  mRowIndexShift = 0;
+
+  mFileTransferStats.clear();
+  mFileTransferProgressChanged.clear();
+
+  for (auto &message : mPendingThumbnails)
+    ThumbnailGenerator::getInstance()->cancel(message);
+  mPendingThumbnails.clear();
+
+  // Remove the history which is not loaded.
+  callLogs.splice(callLogs.end(), mPendingCallLogs);
+
+  ::unrefHistoryThumbnails(mChatRoom, mLoadedMessagesCount);
+
+  mChatRoom->deleteHistory();
+  mLoadedMessagesCount = 0;
 
   endResetModel();
 
+  ::removeCallLogs(callLogs);
+
   emit allEntriesRemoved();
 }
 
@@ -359,18 +706,23 @@ void ChatModel::resendMessage (int id) {
     return;
   }
 
-  const ChatEntryData entry = mEntries[id];
-  const QVariantMap map = entry.first;
+  const ChatEntryData &entry = mEntries[id];
 
-  if (map["type"] != EntryType::MessageEntry) {
+  if (entry.type != EntryType::MessageEntry) {
     qWarning() << QStringLiteral("Unable to resend entry %1. It's not a message.").arg(id);
     return;
   }
 
-  switch (map["status"].toInt()) {
+  switch (entry.status) {
     case MessageStatusFileTransferError:
     case MessageStatusNotDelivered: {
-      shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.second);
+      shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
+      if (message->getFileTransferInformation() && !::fileWasDownloaded(message)) {
+        qWarning() << QStringLiteral("Unable to resend message: %1. File not found: `%2`.")
+          .arg(id).arg(::getDownloadPath(message));
+        break;
+      }
+
       message->setListener(mMessageHandlers);
       message->resend();
 
@@ -387,8 +739,9 @@ void ChatModel::sendFileMessage (const QString &path) {
   if (!file.exists())
     return;
 
+  // The size is given to the core in a `size_t`.
   qint64 fileSize = file.size();
-  if (fileSize > FILE_SIZE_LIMIT) {
+  if (fileSize >= FILE_SIZE_LIMIT || static_cast<quint64>(fileSize) > numeric_limits<size_t>::max()) {
     qWarning() << QStringLiteral("Unable to send file. (Size limit=%1)").arg(FILE_SIZE_LIMIT);
     return;
   }
@@ -400,11 +753,13 @@ void ChatModel::sendFileMessage (const QString &path) {
   content->setSize(static_cast<size_t>(fileSize));
   content->setName(::Utils::appStringToCoreString(QFileInfo(file).fileName()));
 
+  // No file transfer path is given to the core, the file is streamed by `onFileTransferSend`.
+  // The source path is kept in the app data to resend the message.
   shared_ptr<linphone::ChatMessage> message = mChatRoom->createFileTransferMessage(content);
-  message->setFileTransferFilepath(::Utils::appStringToCoreString(path));
+  message->setAppdata(':' + ::Utils::appStringToCoreString(QFileInfo(file).absoluteFilePath()));
   message->setListener(mMessageHandlers);
 
-  ::createThumbnail(message);
+  requestThumbnail(message);
 
   insertMessageAtEnd(message);
   mChatRoom->sendChatMessage(message);
@@ -416,10 +771,10 @@ void ChatModel::sendFileMessage (const QString &path) {
 
 void ChatModel::downloadFile (int id) {
   const ChatEntryData entry = getFileMessageEntry(id);
-  if (!entry.second)
+  if (!entry.linphonePtr)
     return;
 
-  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.second);
+  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
 
   switch (message->getState()) {
     case MessageStatusDelivered:
@@ -433,32 +788,22 @@ void ChatModel::downloadFile (int id) {
       return;
   }
 
-  bool soFarSoGood;
-  const QString safeFilePath = ::Utils::getSafeFilePath(
-      QStringLiteral("%1%2")
-      .arg(CoreManager::getInstance()->getSettingsModel()->getDownloadFolder())
-      .arg(entry.first["fileName"].toString()),
-      &soFarSoGood
-    );
-
-  if (!soFarSoGood) {
-    qWarning() << QStringLiteral("Unable to create safe file path for: %1.").arg(id);
-    return;
-  }
-
-  message->setFileTransferFilepath(::Utils::appStringToCoreString(safeFilePath));
   message->setListener(mMessageHandlers);
+  FileTransferScheduler::getInstance()->download(message, FileTransferScheduler::UserPriority);
+}
 
-  if (message->downloadFile() < 0)
-    qWarning() << QStringLiteral("Unable to download file of entry %1.").arg(id);
+void ChatModel::cancelFileDownload (int id) {
+  const ChatEntryData entry = getFileMessageEntry(id);
+  if (entry.linphonePtr)
+    FileTransferScheduler::getInstance()->cancel(static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr));
 }
 
 void ChatModel::openFile (int id, bool showDirectory) {
   const ChatEntryData entry = getFileMessageEntry(id);
-  if (!entry.second)
+  if (!entry.linphonePtr)
     return;
 
-  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.second);
+  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
   if (!::fileWasDownloaded(message)) {
     downloadFile(id);
     return;
@@ -472,7 +817,7 @@ void ChatModel::openFile (int id, bool showDirectory) {
 
 bool ChatModel::fileWasDownloaded (int id) {
   const ChatEntryData entry = getFileMessageEntry(id);
-  return entry.second && ::fileWasDownloaded(static_pointer_cast<linphone::ChatMessage>(entry.second));
+  return entry.linphonePtr && ::fileWasDownloaded(static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr));
 }
 
 void ChatModel::compose () {
@@ -495,12 +840,12 @@ const ChatModel::ChatEntryData ChatModel::getFileMessageEntry (int id) {
   }
 
   const ChatEntryData entry = mEntries[id];
-  if (entry.first["type"] != EntryType::MessageEntry) {
+  if (entry.type != EntryType::MessageEntry) {
     qWarning() << QStringLiteral("Unable to download entry %1. It's not a message.").arg(id);
     return ChatEntryData();
   }
 
-  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.second);
+  shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
   if (!message->getFileTransferInformation()) {
     qWarning() << QStringLiteral("Entry %1 is not a file message.").arg(id);
     return ChatEntryData();
@@ -511,81 +856,120 @@ const ChatModel::ChatEntryData ChatModel::getFileMessageEntry (int id) {
 
 // -----------------------------------------------------------------------------
 
-void ChatModel::fillMessageEntry (QVariantMap &dest, const shared_ptr<linphone::ChatMessage> &message) {
-  dest["type"] = EntryType::MessageEntry;
-  dest["timestamp"] = QDateTime::fromMSecsSinceEpoch(message->getTime() * 1000);
-  dest["content"] = ::Utils::coreStringToAppString(message->getText());
-  dest["isOutgoing"] = message->isOutgoing() || message->getState() == linphone::ChatMessageStateIdle;
-  dest["status"] = message->getState();
+void ChatModel::fillMessageEntry (ChatEntryData &dest, const shared_ptr<linphone::ChatMessage> &message) {
+  dest.linphonePtr = message;
+  dest.type = EntryType::MessageEntry;
+  dest.timestamp = static_cast<qint64>(message->getTime()) * 1000;
+  dest.content = ::Utils::coreStringToAppString(message->getText());
+  dest.isOutgoing = message->isOutgoing() || message->getState() == linphone::ChatMessageStateIdle;
+  dest.status = message->getState();
 
   shared_ptr<const linphone::Content> content = message->getFileTransferInformation();
   if (content) {
-    dest["fileSize"] = static_cast<quint64>(content->getSize());
-    dest["fileName"] = ::Utils::coreStringToAppString(content->getName());
-    dest["wasDownloaded"] = ::fileWasDownloaded(message);
+    dest.isFile = true;
+    dest.fileSize = static_cast<quint64>(content->getSize());
+    dest.fileName = ::Utils::coreStringToAppString(content->getName());
+    dest.wasDownloaded = ::fileWasDownloaded(message);
+
+    // Evicted thumbnail, create it again if the file is available.
+    const QString fileId = ::getFileId(message);
+    if (!fileId.isEmpty() && !ThumbnailGenerator::getInstance()->exists(fileId)) {
+      const QString downloadPath = ::getDownloadPath(message);
+      message->setAppdata(
+        downloadPath.isEmpty() ? string() : ::Utils::appStringToCoreString(':' + downloadPath)
+      );
+      if (::fileWasDownloaded(message))
+        requestThumbnail(message);
+    }
 
-    ::fillThumbnailProperty(dest, message);
+    ::fillThumbnailProperty(dest.thumbnail, message);
   }
 }
 
-void ChatModel::fillCallStartEntry (QVariantMap &dest, const shared_ptr<linphone::CallLog> &callLog) {
-  QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(callLog->getStartDate() * 1000);
-
-  dest["type"] = EntryType::CallEntry;
-  dest["timestamp"] = timestamp;
-  dest["isOutgoing"] = callLog->getDir() == linphone::CallDirOutgoing;
-  dest["status"] = callLog->getStatus();
-  dest["isStart"] = true;
+void ChatModel::fillCallStartEntry (ChatEntryData &dest, const shared_ptr<linphone::CallLog> &callLog) {
+  dest.linphonePtr = callLog;
+  dest.type = EntryType::CallEntry;
+  dest.timestamp = static_cast<qint64>(callLog->getStartDate()) * 1000;
+  dest.isOutgoing = callLog->getDir() == linphone::CallDirOutgoing;
+  dest.status = callLog->getStatus();
+  dest.isStart = true;
 }
 
-void ChatModel::fillCallEndEntry (QVariantMap &dest, const shared_ptr<linphone::CallLog> &callLog) {
-  QDateTime timestamp = QDateTime::fromMSecsSinceEpoch((callLog->getStartDate() + callLog->getDuration()) * 1000);
-
-  dest["type"] = EntryType::CallEntry;
-  dest["timestamp"] = timestamp;
-  dest["isOutgoing"] = callLog->getDir() == linphone::CallDirOutgoing;
-  dest["status"] = callLog->getStatus();
-  dest["isStart"] = false;
+void ChatModel::fillCallEndEntry (ChatEntryData &dest, const shared_ptr<linphone::CallLog> &callLog) {
+  dest.linphonePtr = callLog;
+  dest.type = EntryType::CallEntry;
+  dest.timestamp = static_cast<qint64>(callLog->getStartDate() + callLog->getDuration()) * 1000;
+  dest.isOutgoing = callLog->getDir() == linphone::CallDirOutgoing;
+  dest.status = callLog->getStatus();
+  dest.isStart = false;
 }
 
 // -----------------------------------------------------------------------------
 
-void ChatModel::removeEntry (ChatEntryData &pair) {
-  int type = pair.first["type"].toInt();
+void ChatModel::removeEntry (ChatEntryData &entry, list<shared_ptr<linphone::CallLog> > &callLogs) {
+  int type = entry.type;
 
   switch (type) {
     case ChatModel::MessageEntry: {
-      shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(pair.second);
+      shared_ptr<linphone::ChatMessage> message = static_pointer_cast<linphone::ChatMessage>(entry.linphonePtr);
       ::removeFileMessageThumbnail(message);
+      cancelThumbnail(message);
       mChatRoom->deleteMessage(message);
+      --mLoadedMessagesCount;
+      emit messageRemoved(message);
       break;
     }
 
-    case ChatModel::CallEntry: {
-      if (pair.first["status"].toInt() == linphone::CallStatusSuccess) {
-        // WARNING: Unable to remove symmetric call here. (start/end)
-        // We are between `beginRemoveRows` and `endRemoveRows`.
-        // A solution is to schedule a `removeEntry` call in the Qt main loop.
-        shared_ptr<void> linphonePtr = pair.second;
-        QTimer::singleShot(0, this, [this, linphonePtr]() {
-            auto it = find_if(mEntries.begin(), mEntries.end(), [linphonePtr](const ChatEntryData &pair) {
-                  return pair.second == linphonePtr;
-                });
-
-            if (it != mEntries.end())
-              removeEntry(static_cast<int>(distance(mEntries.begin(), it)));
-          });
-      }
-
-      CoreManager::getInstance()->getCore()->removeCallLog(static_pointer_cast<linphone::CallLog>(pair.second));
+    case ChatModel::CallEntry:
+      // Removed in the main loop, see `removeCallLogs`.
+      callLogs.push_back(static_pointer_cast<linphone::CallLog>(entry.linphonePtr));
       break;
-    }
 
     default:
       qWarning() << QStringLiteral("Unknown chat entry type: %1.").arg(type);
   }
 }
 
+void ChatModel::removeSymmetricCallEntries (const list<shared_ptr<linphone::CallLog> > &callLogs) {
+  QSet<const void *> removedCallLogs;
+  for (const auto &callLog : callLogs)
+    removedCallLogs.insert(callLog.get());
+
+  // Remove the ranges of symmetric entries (start/end) from the end.
+  for (int row = mEntries.count() - 1; row >= 0; --row) {
+    if (!removedCallLogs.contains(mEntries[row].linphonePtr.get()))
+      continue;
+
+    int last = row;
+    while (row > 0 && removedCallLogs.contains(mEntries[row - 1].linphonePtr.get()))
+      --row;
+
+    beginRemoveRows(QModelIndex(), row, last);
+    mEntries.erase(mEntries.begin() + row, mEntries.begin() + last + 1);
+    shiftRowIndex(row, row - last - 1);
+    endRemoveRows();
+  }
+}
+
+QList<ChatModel::ChatEntryData>::iterator ChatModel::insertEntry (
+  const ChatEntryData &entry,
+  const QList<ChatEntryData>::iterator *start
+) {
+  auto it = lower_bound(start ? *start : mEntries.begin(), mEntries.end(), entry, [](const ChatEntryData &a, const ChatEntryData &b) {
+        return a.timestamp < b.timestamp;
+      });
+
+  int row = static_cast<int>(distance(mEntries.begin(), it));
+
+  beginInsertRows(QModelIndex(), row, row);
+  shiftRowIndex(row, 1);
+  it = mEntries.insert(it, entry);
+  indexRows(row, row);
+  endInsertRows();
+
+  return it;
+}
+
 void ChatModel::insertCall (const shared_ptr<linphone::CallLog> &callLog) {
   linphone::CallStatus status = callLog->getStatus();
 
@@ -600,33 +984,16 @@ void ChatModel::insertCall (const shared_ptr<linphone::CallLog> &callLog) {
       break;
   }
 
-  auto insertEntry = [this](
-      const ChatEntryData &pair,
-      const QList<ChatEntryData>::iterator *start = NULL
-    ) {
-      auto it = lower_bound(start ? *start : mEntries.begin(), mEntries.end(), pair, [](const ChatEntryData &a, const ChatEntryData &b) {
-            return a.first["timestamp"] < b.first["timestamp"];
-          });
-
-      int row = static_cast<int>(distance(mEntries.begin(), it));
-
-      beginInsertRows(QModelIndex(), row, row);
-      it = mEntries.insert(it, pair);
-      endInsertRows();
-
-      return it;
-    };
-
   // Add start call.
-  QVariantMap start;
+  ChatEntryData start;
   fillCallStartEntry(start, callLog);
-  auto it = insertEntry(qMakePair(start, static_pointer_cast<void>(callLog)));
+  auto it = insertEntry(start);
 
   // Add end call. (if necessary)
   if (status == linphone::CallStatusSuccess) {
-    QVariantMap end;
+    ChatEntryData end;
     fillCallEndEntry(end, callLog);
-    insertEntry(qMakePair(end, static_pointer_cast<void>(callLog)), &it);
+    insertEntry(end, &it);
   }
 }
 
@@ -635,15 +1002,158 @@ void ChatModel::insertMessageAtEnd (const shared_ptr<linphone::ChatMessage> &mes
 
   beginInsertRows(QModelIndex(), row, row);
 
-  QVariantMap map;
-  fillMessageEntry(map, message);
-  mEntries << qMakePair(map, static_pointer_cast<void>(message));
+  ChatEntryData entry;
+  fillMessageEntry(entry, message);
+  mEntries << entry;
+  indexRows(row, row);
+  ++mLoadedMessagesCount;
 
   endInsertRows();
 }
 
 // -----------------------------------------------------------------------------
 
+int ChatModel::findMessageRow (const shared_ptr<linphone::ChatMessage> &message) const {
+  auto it = mRowIndex.constFind(message.get());
+  return it == mRowIndex.cend() ? -1 : *it + mRowIndexShift;
+}
+
+void ChatModel::indexRows (int first, int last) {
+  for (int row = first; row <= last; ++row) {
+    const ChatEntryData &entry = mEntries[row];
+    if (entry.type == EntryType::MessageEntry)
+      mRowIndex[entry.linphonePtr.get()] = row - mRowIndexShift;
+  }
+}
+
+void ChatModel::unindexRows (int first, int last) {
+  for (int row = first; row <= last; ++row) {
+    const ChatEntryData &entry = mEntries[row];
+    if (entry.type == EntryType::MessageEntry) {
+      mRowIndex.remove(entry.linphonePtr.get());
+      removeFileTransferStats(entry.linphonePtr.get());
+    }
+  }
+}
+
+void ChatModel::shiftRowIndex (int from, int delta) {
+  // All rows are moved, it's not necessary to update each value.
+  if (from == 0) {
+    mRowIndexShift += delta;
+    return;
+  }
+
+  for (int row = from, count = mEntries.count(); row < count; ++row) {
+    const ChatEntryData &entry = mEntries[row];
+    if (entry.type == EntryType::MessageEntry)
+      mRowIndex[entry.linphonePtr.get()] += delta;
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatModel::updateFileTransferProgress (int row, quint64 offset) {
+  ChatEntryData &entry = mEntries[row];
+  entry.fileOffset = offset;
+
+  // Update speed. (Exponential moving average.)
+  const void *key = entry.linphonePtr.get();
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  auto it = mFileTransferStats.find(key);
+  if (it == mFileTransferStats.end()) {
+    FileTransferStats stats;
+    stats.lastUpdate = now;
+    stats.lastOffset = offset;
+    mFileTransferStats.insert(key, stats);
+  } else if (now - it->lastUpdate >= FILE_TRANSFER_SPEED_INTERVAL && offset >= it->lastOffset) {
+    double speed = (offset - it->lastOffset) * 1000.0 / (now - it->lastUpdate);
+    it->speed = it->speed > 0 ? 0.7 * it->speed + 0.3 * speed : speed;
+    it->lastUpdate = now;
+    it->lastOffset = offset;
+  }
+
+  mFileTransferProgressChanged.insert(key);
+  if (!mFileTransferProgressTimer->isActive())
+    mFileTransferProgressTimer->start();
+}
+
+void ChatModel::removeFileTransferStats (const void *message) {
+  mFileTransferStats.remove(message);
+  mFileTransferProgressChanged.remove(message);
+}
+
+void ChatModel::signalFileTransferProgress () {
+  QVector<int> rows;
+  rows.reserve(mFileTransferProgressChanged.count());
+
+  for (const void *message : mFileTransferProgressChanged) {
+    auto it = mRowIndex.constFind(message);
+    if (it != mRowIndex.cend())
+      rows << *it + mRowIndexShift;
+  }
+  mFileTransferProgressChanged.clear();
+
+  sort(rows.begin(), rows.end());
+
+  // Signal adjacent rows with one range.
+  static const QVector<int> roles = { Roles::FileOffset, Roles::FileSpeed, Roles::FileEta };
+  for (int i = 0, count = rows.count(); i < count;) {
+    int first = rows[i];
+    int last = first;
+    while (++i < count && rows[i] == last + 1)
+      ++last;
+
+    emit dataChanged(index(first, 0), index(last, 0), roles);
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatModel::requestThumbnail (const shared_ptr<linphone::ChatMessage> &message) {
+  if (!::getFileId(message).isEmpty())
+    return;
+
+  QString path = ::getDownloadPath(message);
+  if (path.isEmpty())
+    path = ::Utils::coreStringToAppString(message->getFileTransferFilepath());
+
+  mPendingThumbnails.insert(ThumbnailGenerator::getInstance()->generate(message, path), message);
+}
+
+void ChatModel::cancelThumbnail (const shared_ptr<linphone::ChatMessage> &message) {
+  ThumbnailGenerator::getInstance()->cancel(message);
+  mPendingThumbnails.remove(mPendingThumbnails.key(message, -1));
+}
+
+void ChatModel::handleThumbnailGenerated (int id, const QString &fileId) {
+  auto it = mPendingThumbnails.find(id);
+  if (it == mPendingThumbnails.end())
+    return;
+
+  shared_ptr<linphone::ChatMessage> message = *it;
+  mPendingThumbnails.erase(it);
+
+  // The file id is already set on the message by the generator.
+  if (fileId.isEmpty())
+    return;
+
+  int row = findMessageRow(message);
+  if (row == -1)
+    return;
+
+  ::fillThumbnailProperty(mEntries[row].thumbnail, message);
+  emit dataChanged(index(row, 0), index(row, 0), { Roles::Thumbnail });
+}
+
+void ChatModel::handleFileQueuedChanged (const shared_ptr<linphone::ChatMessage> &message) {
+  int row = findMessageRow(message);
+  if (row != -1)
+    emit dataChanged(index(row, 0), index(row, 0), { Roles::IsFileQueued });
+}
+
+// -----------------------------------------------------------------------------
+
 void ChatModel::handleCallStateChanged (const shared_ptr<linphone::Call> &call, linphone::CallState state) {
   if (
     (state == linphone::CallStateEnd || state == linphone::CallStateError) &&
@@ -665,6 +1175,11 @@ void ChatModel::handleIsComposingChanged (const shared_ptr<linphone::ChatRoom> &
 void ChatModel::handleMessageReceived (const shared_ptr<linphone::ChatMessage> &message) {
   if (mChatRoom == message->getChatRoom()) {
     insertMessageAtEnd(message);
+
+    // The automatic download is started by the scheduler, display its progress.
+    if (message->getFileTransferInformation())
+      message->setListener(mMessageHandlers);
+
     emit messageReceived(message);
   }
 }
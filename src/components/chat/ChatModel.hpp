@@ -25,11 +25,14 @@
 
 #include <linphone++/linphone.hh>
 #include <QAbstractListModel>
+#include <QSet>
 
 // =============================================================================
-// Fetch all N messages of a ChatRoom.
+// Fetch the N last messages of a ChatRoom, older entries are loaded on demand.
 // =============================================================================
 
+class QTimer;
+
 class CoreHandlers;
 
 class ChatModel : public QAbstractListModel {
@@ -39,8 +42,23 @@ class ChatModel : public QAbstractListModel {
 
 public:
   enum Roles {
-    ChatEntry = Qt::DisplayRole,
-    SectionDate
+    ChatEntry = Qt::DisplayRole, // Deprecated. Build a `QVariantMap` on each call, use the typed roles.
+    SectionDate,
+
+    Type = Qt::UserRole,
+    Timestamp,
+    Content,
+    IsOutgoing,
+    IsStart,
+    Status,
+    FileName,
+    FileSize,
+    FileOffset,
+    WasDownloaded,
+    Thumbnail,
+    FileSpeed, // In bytes/s.
+    FileEta, // In seconds, -1 if unknown.
+    IsFileQueued // Download waiting for a slot, it can be cancelled.
   };
 
   enum EntryType {
@@ -87,6 +105,13 @@ public:
 
   bool getIsRemoteComposing () const;
 
+  // Load an older page of history. Returns the number of inserted entries.
+  int loadMoreEntries ();
+  bool canLoadMoreEntries () const;
+
+  // Load the history until a message and return its row. (-1 if not found.)
+  int findMessageEntry (qint64 timestamp, const QString &content);
+
   void removeEntry (int id);
   void removeAllEntries ();
 
@@ -96,7 +121,9 @@ public:
 
   void sendFileMessage (const QString &path);
 
+  // Downloads are queued, see `FileTransferScheduler`.
   void downloadFile (int id);
+  void cancelFileDownload (int id);
   void openFile (int id, bool showDirectory = false);
   void openFileDirectory (int id) {
     openFile(id, true);
@@ -108,6 +135,10 @@ public:
 
   void resetMessagesCount ();
 
+  // Listener of the messages without chat model. (Automatic downloads.)
+  // It's replaced by the handlers of a chat model when the message is displayed.
+  static std::shared_ptr<linphone::ChatMessageListener> getDetachedMessageHandlers ();
+
 signals:
   bool isRemoteComposingChanged (bool status);
 
@@ -115,25 +146,69 @@ signals:
 
   void messageSent (const std::shared_ptr<linphone::ChatMessage> &message);
   void messageReceived (const std::shared_ptr<linphone::ChatMessage> &message);
+  void messageRemoved (const std::shared_ptr<linphone::ChatMessage> &message);
+  void callLogsRemoved (const std::list<std::shared_ptr<linphone::CallLog> > &callLogs);
 
   void messagesCountReset ();
 
 private:
-  typedef QPair<QVariantMap, std::shared_ptr<void> > ChatEntryData;
+  // Members are ordered by size to limit padding.
+  struct ChatEntryData {
+    std::shared_ptr<void> linphonePtr; // `ChatMessage` or `CallLog`.
+
+    qint64 timestamp = 0; // In ms since epoch.
+    quint64 fileSize = 0;
+    quint64 fileOffset = 0;
+
+    QString content;
+    QString fileName;
+    QString thumbnail;
+
+    int status = 0;
+    EntryType type = GenericEntry;
+
+    bool isOutgoing = false;
+    bool isStart = false; // Call entries only.
+    bool isFile = false;
+    bool wasDownloaded = false;
+  };
+
+  QVariantMap toVariantMap (const ChatEntryData &entry) const;
 
   void setSipAddress (const QString &sipAddress);
 
   const ChatEntryData getFileMessageEntry (int id);
 
-  void fillMessageEntry (QVariantMap &dest, const std::shared_ptr<linphone::ChatMessage> &message);
-  void fillCallStartEntry (QVariantMap &dest, const std::shared_ptr<linphone::CallLog> &callLog);
-  void fillCallEndEntry (QVariantMap &dest, const std::shared_ptr<linphone::CallLog> &callLog);
+  void fillMessageEntry (ChatEntryData &dest, const std::shared_ptr<linphone::ChatMessage> &message);
+  void fillCallStartEntry (ChatEntryData &dest, const std::shared_ptr<linphone::CallLog> &callLog);
+  void fillCallEndEntry (ChatEntryData &dest, const std::shared_ptr<linphone::CallLog> &callLog);
 
-  void removeEntry (ChatEntryData &pair);
+  void removeEntry (ChatEntryData &entry, std::list<std::shared_ptr<linphone::CallLog> > &callLogs);
+  void removeSymmetricCallEntries (const std::list<std::shared_ptr<linphone::CallLog> > &callLogs);
 
+  QList<ChatEntryData>::iterator insertEntry (const ChatEntryData &entry, const QList<ChatEntryData>::iterator *start = NULL);
   void insertCall (const std::shared_ptr<linphone::CallLog> &callLog);
   void insertMessageAtEnd (const std::shared_ptr<linphone::ChatMessage> &message);
 
+  int findMessageRow (const std::shared_ptr<linphone::ChatMessage> &message) const;
+
+  // Must be called after insertions/before removals.
+  void indexRows (int first, int last);
+  void unindexRows (int first, int last);
+
+  // Update the rows of the indexed messages placed at `from` and after.
+  void shiftRowIndex (int from, int delta);
+
+  void updateFileTransferProgress (int row, quint64 offset);
+  void removeFileTransferStats (const void *message);
+  void signalFileTransferProgress ();
+
+  void requestThumbnail (const std::shared_ptr<linphone::ChatMessage> &message);
+  void cancelThumbnail (const std::shared_ptr<linphone::ChatMessage> &message);
+  void handleThumbnailGenerated (int id, const QString &fileId);
+
+  void handleFileQueuedChanged (const std::shared_ptr<linphone::ChatMessage> &message);
+
   void handleCallStateChanged (const std::shared_ptr<linphone::Call> &call, linphone::CallState state);
   void handleIsComposingChanged (const std::shared_ptr<linphone::ChatRoom> &chatRoom);
   void handleMessageReceived (const std::shared_ptr<linphone::ChatMessage> &message);
@@ -143,6 +218,33 @@ private:
   QList<ChatEntryData> mEntries;
   std::shared_ptr<linphone::ChatRoom> mChatRoom;
 
+  // Number of history messages represented in `mEntries`.
+  int mLoadedMessagesCount = 0;
+
+  // Message -> row index. The row of a message is `value + mRowIndexShift`,
+  // so prepending a page doesn't require to update the existing values.
+  QHash<const void *, int> mRowIndex;
+  int mRowIndexShift = 0;
+
+  // Throughput of the running file transfers.
+  struct FileTransferStats {
+    qint64 lastUpdate = 0; // In ms.
+    quint64 lastOffset = 0;
+    double speed = 0; // In bytes/s.
+  };
+
+  QHash<const void *, FileTransferStats> mFileTransferStats;
+
+  // Progress changes are signaled at most once per frame.
+  QSet<const void *> mFileTransferProgressChanged;
+  QTimer *mFileTransferProgressTimer = nullptr;
+
+  // Thumbnails created in background. (Request id => message.)
+  QHash<int, std::shared_ptr<linphone::ChatMessage> > mPendingThumbnails;
+
+  // Call logs not yet displayed, sorted by start date. (Oldest first.)
+  std::list<std::shared_ptr<linphone::CallLog> > mPendingCallLogs;
+
   std::shared_ptr<CoreHandlers> mCoreHandlers;
   std::shared_ptr<MessageHandlers> mMessageHandlers;
 };
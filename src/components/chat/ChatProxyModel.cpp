@@ -20,49 +20,71 @@
  *      Author: Ronan Abhamon
  */
 
+#include <algorithm>
+
 #include "../core/CoreManager.hpp"
 
+#include "FileTransferScheduler.hpp"
+
 #include "ChatProxyModel.hpp"
 
 using namespace std;
 
 // =============================================================================
 
-// Fetch the L last filtered chat entries.
-class ChatProxyModel::ChatModelFilter : public QSortFilterProxyModel {
-public:
-  ChatModelFilter (QObject *parent) : QSortFilterProxyModel(parent) {}
+const int ChatProxyModel::ENTRIES_CHUNK_SIZE = 50;
 
-  ChatModel::EntryType getEntryTypeFilter () {
-    return mEntryTypeFilter;
-  }
+// History pages fetched by one `loadMoreEntries` call to find an entry of the filtered type.
+const int ChatProxyModel::MAX_FETCHED_PAGES = 20;
 
-  void setEntryTypeFilter (ChatModel::EntryType type) {
-    mEntryTypeFilter = type;
-    invalidate();
-  }
+ChatProxyModel::ChatProxyModel (QObject *parent) : QAbstractProxyModel(parent) {}
 
-protected:
-  bool filterAcceptsRow (int sourceRow, const QModelIndex &) const override {
-    if (mEntryTypeFilter == ChatModel::EntryType::GenericEntry)
-      return true;
+ChatProxyModel::~ChatProxyModel () {
+  if (mChatModel)
+    FileTransferScheduler::getInstance()->removeVisibleChatRoom(mChatModel->getSipAddress());
+}
 
-    QModelIndex index = sourceModel()->index(sourceRow, 0, QModelIndex());
-    const QVariantMap data = index.data().toMap();
+// -----------------------------------------------------------------------------
 
-    return data["type"].toInt() == mEntryTypeFilter;
-  }
+QModelIndex ChatProxyModel::index (int row, int column, const QModelIndex &parent) const {
+  if (parent.isValid() || column != 0 || row < 0 || row >= rowCount())
+    return QModelIndex();
+  return createIndex(row, column);
+}
+
+QModelIndex ChatProxyModel::parent (const QModelIndex &) const {
+  return QModelIndex();
+}
 
-private:
-  ChatModel::EntryType mEntryTypeFilter = ChatModel::EntryType::GenericEntry;
-};
+int ChatProxyModel::rowCount (const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : static_cast<int>(mSourceRows.size()) - mFirstDisplayedPosition;
+}
 
-// =============================================================================
+int ChatProxyModel::columnCount (const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : 1;
+}
 
-const int ChatProxyModel::ENTRIES_CHUNK_SIZE = 50;
+QHash<int, QByteArray> ChatProxyModel::roleNames () const {
+  return mChatModel ? mChatModel->roleNames() : QHash<int, QByteArray>();
+}
+
+QModelIndex ChatProxyModel::mapFromSource (const QModelIndex &sourceIndex) const {
+  if (!sourceIndex.isValid() || sourceIndex.model() != mChatModel.get())
+    return QModelIndex();
+
+  int sourceRow = sourceIndex.row();
+  int position = findPosition(sourceRow);
+  if (position < mFirstDisplayedPosition || position >= static_cast<int>(mSourceRows.size()) || getSourceRow(position) != sourceRow)
+    return QModelIndex();
 
-ChatProxyModel::ChatProxyModel (QObject *parent) : QSortFilterProxyModel(parent) {
-  setSourceModel(new ChatModelFilter(this));
+  return createIndex(position - mFirstDisplayedPosition, 0);
+}
+
+QModelIndex ChatProxyModel::mapToSource (const QModelIndex &proxyIndex) const {
+  if (!proxyIndex.isValid() || !mChatModel)
+    return QModelIndex();
+
+  return mChatModel->index(getSourceRow(mFirstDisplayedPosition + proxyIndex.row()), 0);
 }
 
 // -----------------------------------------------------------------------------
@@ -85,9 +107,7 @@ ChatProxyModel::ChatProxyModel (QObject *parent) : QSortFilterProxyModel(parent)
 #define CREATE_PARENT_MODEL_FUNCTION_WITH_ID(METHOD) \
   void ChatProxyModel::METHOD(int id) { \
     QModelIndex sourceIndex = mapToSource(index(id, 0)); \
-    GET_CHAT_MODEL()->METHOD( \
-      static_cast<ChatModelFilter *>(sourceModel())->mapToSource(sourceIndex).row() \
-    ); \
+    GET_CHAT_MODEL()->METHOD(sourceIndex.row()); \
   }
 
 CREATE_PARENT_MODEL_FUNCTION(compose);
@@ -96,6 +116,7 @@ CREATE_PARENT_MODEL_FUNCTION(removeAllEntries);
 CREATE_PARENT_MODEL_FUNCTION_WITH_PARAM(sendFileMessage, const QString &);
 CREATE_PARENT_MODEL_FUNCTION_WITH_PARAM(sendMessage, const QString &);
 
+CREATE_PARENT_MODEL_FUNCTION_WITH_ID(cancelFileDownload);
 CREATE_PARENT_MODEL_FUNCTION_WITH_ID(downloadFile);
 CREATE_PARENT_MODEL_FUNCTION_WITH_ID(openFile);
 CREATE_PARENT_MODEL_FUNCTION_WITH_ID(openFileDirectory);
@@ -110,36 +131,66 @@ CREATE_PARENT_MODEL_FUNCTION_WITH_ID(resendMessage);
 // -----------------------------------------------------------------------------
 
 void ChatProxyModel::loadMoreEntries () {
-  int count = rowCount();
-  int parentCount = sourceModel()->rowCount();
-
-  if (count < parentCount) {
-    // Do not increase `mMaxDisplayedEntries` if it's not necessary...
-    // Limit qml calls.
-    if (count == mMaxDisplayedEntries)
-      mMaxDisplayedEntries += ENTRIES_CHUNK_SIZE;
-
-    invalidateFilter();
+  if (!mChatModel)
+    return;
+
+  // All loaded entries are displayed, fetch older pages of history.
+  // Their rows are hidden, see `handleSourceRowsInserted`.
+  // Note: A page can contain no entry of the filtered type, the next one is fetched.
+  // Beyond the limit, the search continues at the next call.
+  if (mFirstDisplayedPosition == 0) {
+    mIsFetching = true;
+    for (int i = 0; i < MAX_FETCHED_PAGES && mFirstDisplayedPosition == 0 && mChatModel->canLoadMoreEntries(); ++i)
+      mChatModel->loadMoreEntries();
+    mIsFetching = false;
+  }
 
-    count = rowCount() - count;
-    if (count > 0)
-      emit moreEntriesLoaded(count);
+  // Only the new chunk is inserted.
+  int count = min(mFirstDisplayedPosition, ENTRIES_CHUNK_SIZE);
+  if (count > 0) {
+    beginInsertRows(QModelIndex(), 0, count - 1);
+    mFirstDisplayedPosition -= count;
+    endInsertRows();
   }
+
+  emit moreEntriesLoaded(count);
 }
 
 void ChatProxyModel::setEntryTypeFilter (ChatModel::EntryType type) {
-  ChatModelFilter *chatModelFilter = static_cast<ChatModelFilter *>(sourceModel());
+  if (mEntryTypeFilter == type)
+    return;
 
-  if (chatModelFilter->getEntryTypeFilter() != type) {
-    chatModelFilter->setEntryTypeFilter(type);
-    emit entryTypeFilterChanged(type);
-  }
+  // Keep the same number of displayed entries.
+  int count = max(rowCount(), ENTRIES_CHUNK_SIZE);
+
+  beginResetModel();
+  mEntryTypeFilter = type;
+  rebuildSourceRows();
+  mFirstDisplayedPosition = max(static_cast<int>(mSourceRows.size()) - count, 0);
+  endResetModel();
+
+  emit entryTypeFilterChanged(type);
 }
 
-// -----------------------------------------------------------------------------
+int ChatProxyModel::loadMessageEntry (const QDateTime &timestamp, const QString &content) {
+  if (!mChatModel)
+    return -1;
+
+  int sourceRow = mChatModel->findMessageEntry(timestamp.toMSecsSinceEpoch(), content);
+  if (sourceRow == -1)
+    return -1;
 
-bool ChatProxyModel::filterAcceptsRow (int sourceRow, const QModelIndex &) const {
-  return sourceModel()->rowCount() - sourceRow <= mMaxDisplayedEntries;
+  int position = findPosition(sourceRow);
+  if (position >= static_cast<int>(mSourceRows.size()) || getSourceRow(position) != sourceRow)
+    return -1;
+
+  if (position < mFirstDisplayedPosition) {
+    beginInsertRows(QModelIndex(), 0, mFirstDisplayedPosition - position - 1);
+    mFirstDisplayedPosition = position;
+    endInsertRows();
+  }
+
+  return position - mFirstDisplayedPosition;
 }
 
 // -----------------------------------------------------------------------------
@@ -149,27 +200,41 @@ QString ChatProxyModel::getSipAddress () const {
 }
 
 void ChatProxyModel::setSipAddress (const QString &sipAddress) {
-  mMaxDisplayedEntries = ENTRIES_CHUNK_SIZE;
+  beginResetModel();
+
+  FileTransferScheduler *fileTransferScheduler = FileTransferScheduler::getInstance();
 
   if (mChatModel) {
     ChatModel *chatModel = mChatModel.get();
-    QObject::disconnect(chatModel, &ChatModel::isRemoteComposingChanged, this, &ChatProxyModel::handleIsRemoteComposingChanged);
-    QObject::disconnect(chatModel, &ChatModel::messageReceived, this, &ChatProxyModel::handleMessageReceived);
-    QObject::disconnect(chatModel, &ChatModel::messageSent, this, &ChatProxyModel::handleMessageSent);
+    QObject::disconnect(chatModel, nullptr, this, nullptr);
+    fileTransferScheduler->removeVisibleChatRoom(chatModel->getSipAddress());
   }
 
   mChatModel = CoreManager::getInstance()->getChatModelFromSipAddress(sipAddress);
 
   if (mChatModel) {
     mChatModel->resetMessagesCount();
+    fileTransferScheduler->addVisibleChatRoom(mChatModel->getSipAddress());
 
     ChatModel *chatModel = mChatModel.get();
     QObject::connect(chatModel, &ChatModel::isRemoteComposingChanged, this, &ChatProxyModel::handleIsRemoteComposingChanged);
     QObject::connect(chatModel, &ChatModel::messageReceived, this, &ChatProxyModel::handleMessageReceived);
-    QObject::connect(chatModel, &ChatModel::messageSent, this, &ChatProxyModel::handleMessageSent);
+
+    QObject::connect(chatModel, &ChatModel::rowsInserted, this, &ChatProxyModel::handleSourceRowsInserted);
+    QObject::connect(chatModel, &ChatModel::rowsAboutToBeRemoved, this, &ChatProxyModel::handleSourceRowsAboutToBeRemoved);
+    QObject::connect(chatModel, &ChatModel::rowsRemoved, this, &ChatProxyModel::handleSourceRowsRemoved);
+    QObject::connect(chatModel, &ChatModel::modelAboutToBeReset, this, &ChatProxyModel::handleSourceModelAboutToBeReset);
+    QObject::connect(chatModel, &ChatModel::modelReset, this, &ChatProxyModel::handleSourceModelReset);
+    QObject::connect(chatModel, &ChatModel::dataChanged, this, &ChatProxyModel::handleSourceDataChanged);
   }
 
-  static_cast<ChatModelFilter *>(sourceModel())->setSourceModel(mChatModel.get());
+  // Note: `QAbstractProxyModel` doesn't handle the source signals, see the handlers below.
+  setSourceModel(mChatModel.get());
+
+  rebuildSourceRows();
+  mFirstDisplayedPosition = max(static_cast<int>(mSourceRows.size()) - ENTRIES_CHUNK_SIZE, 0);
+
+  endResetModel();
 }
 
 bool ChatProxyModel::getIsRemoteComposing () const {
@@ -178,15 +243,143 @@ bool ChatProxyModel::getIsRemoteComposing () const {
 
 // -----------------------------------------------------------------------------
 
+bool ChatProxyModel::acceptsSourceRow (int sourceRow) const {
+  return mEntryTypeFilter == ChatModel::EntryType::GenericEntry ||
+    mChatModel->index(sourceRow, 0).data(ChatModel::Type).toInt() == mEntryTypeFilter;
+}
+
+int ChatProxyModel::findPosition (int sourceRow) const {
+  // Stored rows are sorted, compare them without shift.
+  return static_cast<int>(distance(
+    mSourceRows.cbegin(),
+    lower_bound(mSourceRows.cbegin(), mSourceRows.cend(), sourceRow - mSourceRowsShift)
+  ));
+}
+
+void ChatProxyModel::shiftSourceRows (int from, int delta) {
+  int size = static_cast<int>(mSourceRows.size());
+
+  // Update the smallest part.
+  if (from < size - from) {
+    mSourceRowsShift += delta;
+    for (int i = 0; i < from; ++i)
+      mSourceRows[static_cast<size_t>(i)] -= delta;
+  } else
+    for (int i = from; i < size; ++i)
+      mSourceRows[static_cast<size_t>(i)] += delta;
+}
+
+void ChatProxyModel::rebuildSourceRows () {
+  mSourceRows.clear();
+  mSourceRowsShift = 0;
+
+  if (!mChatModel)
+    return;
+
+  for (int row = 0, count = mChatModel->rowCount(); row < count; ++row)
+    if (acceptsSourceRow(row))
+      mSourceRows.push_back(row);
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatProxyModel::handleSourceRowsInserted (const QModelIndex &, int first, int last) {
+  int count = last - first + 1;
+  int position = findPosition(first);
+
+  shiftSourceRows(position, count);
+
+  QVector<int> rows;
+  for (int row = first; row <= last; ++row)
+    if (acceptsSourceRow(row))
+      rows << row - mSourceRowsShift;
+
+  if (rows.isEmpty())
+    return;
+
+  // Older than the displayed entries, wait a `loadMoreEntries` call.
+  // Fetched rows are hidden even if all the entries are displayed.
+  if (position < mFirstDisplayedPosition || (mIsFetching && position == mFirstDisplayedPosition)) {
+    mSourceRows.insert(mSourceRows.begin() + position, rows.cbegin(), rows.cend());
+    mFirstDisplayedPosition += rows.count();
+    return;
+  }
+
+  int proxyRow = position - mFirstDisplayedPosition;
+  beginInsertRows(QModelIndex(), proxyRow, proxyRow + rows.count() - 1);
+  mSourceRows.insert(mSourceRows.begin() + position, rows.cbegin(), rows.cend());
+  endInsertRows();
+}
+
+void ChatProxyModel::handleSourceRowsAboutToBeRemoved (const QModelIndex &, int first, int last) {
+  mRemovedFirstPosition = findPosition(first);
+  mRemovedLastPosition = findPosition(last + 1) - 1;
+
+  // Displayed part of the removed rows.
+  int firstDisplayed = max(mRemovedFirstPosition, mFirstDisplayedPosition);
+  if (firstDisplayed <= mRemovedLastPosition)
+    beginRemoveRows(
+      QModelIndex(),
+      firstDisplayed - mFirstDisplayedPosition,
+      mRemovedLastPosition - mFirstDisplayedPosition
+    );
+}
+
+void ChatProxyModel::handleSourceRowsRemoved (const QModelIndex &, int first, int last) {
+  int count = mRemovedLastPosition - mRemovedFirstPosition + 1;
+  bool displayed = max(mRemovedFirstPosition, mFirstDisplayedPosition) <= mRemovedLastPosition;
+
+  if (count > 0) {
+    mSourceRows.erase(
+      mSourceRows.begin() + mRemovedFirstPosition,
+      mSourceRows.begin() + mRemovedLastPosition + 1
+    );
+
+    if (mRemovedFirstPosition < mFirstDisplayedPosition)
+      mFirstDisplayedPosition -= min(mRemovedLastPosition + 1, mFirstDisplayedPosition) - mRemovedFirstPosition;
+  }
+
+  shiftSourceRows(mRemovedFirstPosition, first - last - 1);
+
+  mRemovedFirstPosition = 0;
+  mRemovedLastPosition = -1;
+
+  if (displayed)
+    endRemoveRows();
+}
+
+void ChatProxyModel::handleSourceModelAboutToBeReset () {
+  beginResetModel();
+}
+
+void ChatProxyModel::handleSourceModelReset () {
+  rebuildSourceRows();
+  mFirstDisplayedPosition = max(static_cast<int>(mSourceRows.size()) - ENTRIES_CHUNK_SIZE, 0);
+  endResetModel();
+}
+
+void ChatProxyModel::handleSourceDataChanged (
+  const QModelIndex &topLeft,
+  const QModelIndex &bottomRight,
+  const QVector<int> &roles
+) {
+  int first = max(findPosition(topLeft.row()), mFirstDisplayedPosition);
+  int last = findPosition(bottomRight.row() + 1) - 1;
+
+  if (first <= last)
+    emit dataChanged(
+      index(first - mFirstDisplayedPosition, 0),
+      index(last - mFirstDisplayedPosition, 0),
+      roles
+    );
+}
+
+// -----------------------------------------------------------------------------
+
 void ChatProxyModel::handleIsRemoteComposingChanged (bool status) {
   emit isRemoteComposingChanged(status);
 }
 
 void ChatProxyModel::handleMessageReceived (const shared_ptr<linphone::ChatMessage> &) {
-  mMaxDisplayedEntries++;
   mChatModel->resetMessagesCount();
 }
-
-void ChatProxyModel::handleMessageSent (const shared_ptr<linphone::ChatMessage> &) {
-  mMaxDisplayedEntries++;
-}
@@ -23,15 +23,19 @@
 #ifndef CHAT_PROXY_MODEL_H_
 #define CHAT_PROXY_MODEL_H_
 
-#include <QSortFilterProxyModel>
+#include <deque>
+
+#include <QAbstractProxyModel>
+#include <QDateTime>
 
 #include "ChatModel.hpp"
 
+// =============================================================================
+// Display the L last chat entries of a type. Older entries are displayed
+// by chunks, the type-filtered rows are updated incrementally.
 // =============================================================================
 
-class ChatProxyModel : public QSortFilterProxyModel {
-  class ChatModelFilter;
-
+class ChatProxyModel : public QAbstractProxyModel {
   Q_OBJECT;
 
   Q_PROPERTY(QString sipAddress READ getSipAddress WRITE setSipAddress NOTIFY sipAddressChanged);
@@ -39,11 +43,26 @@ class ChatProxyModel : public QSortFilterProxyModel {
 
 public:
   ChatProxyModel (QObject *parent = Q_NULLPTR);
+  ~ChatProxyModel ();
+
+  QModelIndex index (int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+  QModelIndex parent (const QModelIndex &index) const override;
+
+  int rowCount (const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount (const QModelIndex &parent = QModelIndex()) const override;
+
+  QHash<int, QByteArray> roleNames () const override;
+
+  QModelIndex mapFromSource (const QModelIndex &sourceIndex) const override;
+  QModelIndex mapToSource (const QModelIndex &proxyIndex) const override;
 
   Q_INVOKABLE void loadMoreEntries ();
   Q_INVOKABLE void setEntryTypeFilter (ChatModel::EntryType type);
   Q_INVOKABLE void removeEntry (int id);
 
+  // Display the history until a message and return its row. (-1 if not found.)
+  Q_INVOKABLE int loadMessageEntry (const QDateTime &timestamp, const QString &content);
+
   Q_INVOKABLE void removeAllEntries ();
 
   Q_INVOKABLE void sendMessage (const QString &message);
@@ -52,6 +71,7 @@ public:
   Q_INVOKABLE void sendFileMessage (const QString &path);
 
   Q_INVOKABLE void downloadFile (int id);
+  Q_INVOKABLE void cancelFileDownload (int id);
   Q_INVOKABLE void openFile (int id);
   Q_INVOKABLE void openFileDirectory (int id);
 
@@ -65,24 +85,56 @@ signals:
 
   void entryTypeFilterChanged (ChatModel::EntryType type);
 
-protected:
-  bool filterAcceptsRow (int sourceRow, const QModelIndex &sourceParent) const override;
-
 private:
   QString getSipAddress () const;
   void setSipAddress (const QString &sipAddress);
 
   bool getIsRemoteComposing () const;
 
+  bool acceptsSourceRow (int sourceRow) const;
+
+  int getSourceRow (int position) const {
+    return mSourceRows[static_cast<size_t>(position)] + mSourceRowsShift;
+  }
+
+  // Position of the first filtered row greater or equal to `sourceRow`.
+  int findPosition (int sourceRow) const;
+
+  // Add `delta` to the source rows of the positions `from` and after.
+  void shiftSourceRows (int from, int delta);
+
+  void rebuildSourceRows ();
+
+  void handleSourceRowsInserted (const QModelIndex &parent, int first, int last);
+  void handleSourceRowsAboutToBeRemoved (const QModelIndex &parent, int first, int last);
+  void handleSourceRowsRemoved (const QModelIndex &parent, int first, int last);
+  void handleSourceModelAboutToBeReset ();
+  void handleSourceModelReset ();
+  void handleSourceDataChanged (const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+
   void handleIsRemoteComposingChanged (bool status);
   void handleMessageReceived (const std::shared_ptr<linphone::ChatMessage> &message);
-  void handleMessageSent (const std::shared_ptr<linphone::ChatMessage> &message);
 
-  int mMaxDisplayedEntries = ENTRIES_CHUNK_SIZE;
+  ChatModel::EntryType mEntryTypeFilter = ChatModel::EntryType::GenericEntry;
+
+  // Source rows of the entries of the filtered type. (Stored value + shift.)
+  std::deque<int> mSourceRows;
+  int mSourceRowsShift = 0;
+
+  // Position of the first displayed entry in `mSourceRows`.
+  int mFirstDisplayedPosition = 0;
+
+  // A history page is fetched by `loadMoreEntries`.
+  bool mIsFetching = false;
+
+  // Filtered positions removed between `rowsAboutToBeRemoved` and `rowsRemoved`.
+  int mRemovedFirstPosition = 0;
+  int mRemovedLastPosition = -1;
 
   std::shared_ptr<ChatModel> mChatModel;
 
   static const int ENTRIES_CHUNK_SIZE;
+  static const int MAX_FETCHED_PAGES;
 };
 
 #endif // CHAT_PROXY_MODEL_H_
@@ -0,0 +1,733 @@
+/*
+ * ChatSearchIndex.cpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 10, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QTimer>
+
+#include "../../app/paths/Paths.hpp"
+#include "../../utils/Utils.hpp"
+#include "../core/CoreManager.hpp"
+
+#include "ChatSearchIndex.hpp"
+
+// Index file header.
+#define INDEX_MAGIC 0x4C534958
+#define INDEX_VERSION 2
+
+// Longer words are truncated.
+#define MAX_TOKEN_LENGTH 32
+
+// Number of words read for the last token of a query. (Prefix.)
+#define MAX_PREFIX_TERMS 100
+
+// Number of messages indexed per event loop iteration during the first build.
+#define BUILD_CHUNK_SIZE 500
+
+// Delay between a change and the index save. (In ms.)
+#define SAVE_DELAY 30000
+
+// The contents file is rewritten without the removed documents beyond this ratio.
+#define COMPACTION_MIN_REMOVED_COUNT 1000
+#define COMPACTION_REMOVED_RATIO 0.5
+
+#define COMPACTED_CONTENTS_SUFFIX ".compacted"
+
+using namespace std;
+
+// =============================================================================
+
+inline QString getMessageContent (const shared_ptr<linphone::ChatMessage> &message) {
+  shared_ptr<const linphone::Content> content = message->getFileTransferInformation();
+  return content
+    ? ::Utils::coreStringToAppString(content->getName())
+    : ::Utils::coreStringToAppString(message->getText());
+}
+
+inline QString getSipAddress (const shared_ptr<linphone::ChatMessage> &message) {
+  return ::Utils::coreStringToAppString(message->getChatRoom()->getPeerAddress()->asStringUriOnly());
+}
+
+// -----------------------------------------------------------------------------
+
+ChatSearchIndex::ChatSearchIndex (QObject *parent) : QObject(parent) {
+  mIndexPath = ::Utils::coreStringToAppString(Paths::getMessageSearchIndexFilePath());
+  mContentsFile.setFileName(::Utils::coreStringToAppString(Paths::getMessageSearchContentsFilePath()));
+
+  mBuildTimer = new QTimer(this);
+  mBuildTimer->setSingleShot(true);
+  mBuildTimer->setInterval(0);
+  QObject::connect(mBuildTimer, &QTimer::timeout, this, &ChatSearchIndex::buildNextChunk);
+
+  mSaveTimer = new QTimer(this);
+  mSaveTimer->setSingleShot(true);
+  mSaveTimer->setInterval(SAVE_DELAY);
+  QObject::connect(mSaveTimer, &QTimer::timeout, this, &ChatSearchIndex::save);
+
+  CoreManager *coreManager = CoreManager::getInstance();
+  QObject::connect(
+    coreManager->getHandlers().get(), &CoreHandlers::messageReceived,
+    this, &ChatSearchIndex::addMessage
+  );
+  QObject::connect(coreManager, &CoreManager::chatModelCreated, this, &ChatSearchIndex::handleChatModelCreated);
+
+  // The index can be big, load it in background.
+  QObject::connect(&mLoadWatcher, &QFutureWatcher<Data>::finished, this, &ChatSearchIndex::handleLoaded);
+  mLoadWatcher.setFuture(QtConcurrent::run(&ChatSearchIndex::loadData, mIndexPath));
+
+  QObject::connect(&mCompactWatcher, &QFutureWatcher<Data>::finished, this, &ChatSearchIndex::handleCompacted);
+}
+
+ChatSearchIndex::~ChatSearchIndex () {
+  mLoadWatcher.waitForFinished();
+  mSaveWatcher.waitForFinished();
+
+  // The compacted contents are dropped, the current ones are still valid.
+  mCompactWatcher.waitForFinished();
+  if (mData.isBuilt) {
+    mIsLoaded = true;
+    mReadersCount = 0;
+    handlePendingChanges();
+  }
+
+  if (mIsDirty && mData.isBuilt) {
+    mContentsFile.flush();
+    mData.contentsSize = mContentsFile.size();
+    saveData(mIndexPath, mData);
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+QFuture<QVector<quint32> > ChatSearchIndex::search (const QString &query) {
+  QFuture<QVector<quint32> > future = QtConcurrent::run(&ChatSearchIndex::computeHits, mData, tokenize(query));
+  addReader(future);
+  return future;
+}
+
+ChatSearchIndex::Hit ChatSearchIndex::getHit (quint32 id) {
+  Hit hit;
+  if (id >= static_cast<quint32>(mData.documents.count()))
+    return hit;
+
+  const Document &document = mData.documents.at(static_cast<int>(id));
+  hit.sipAddress = mData.sipAddresses.value(static_cast<int>(document.sipAddressId));
+  hit.timestamp = document.time * 1000;
+  hit.isOutgoing = document.isOutgoing;
+
+  if (mContentsFile.seek(document.contentOffset))
+    hit.content = QString::fromUtf8(mContentsFile.read(document.contentSize));
+
+  return hit;
+}
+
+QStringList ChatSearchIndex::tokenize (const QString &text) {
+  QStringList tokens;
+  QString token;
+
+  // Decompose the characters to drop the diacritics.
+  for (const QChar &character : text.normalized(QString::NormalizationForm_KD)) {
+    if (character.isLetterOrNumber()) {
+      if (token.length() < MAX_TOKEN_LENGTH)
+        token += character.toCaseFolded();
+    } else if (character.category() != QChar::Mark_NonSpacing && !token.isEmpty()) {
+      tokens << token;
+      token.clear();
+    }
+  }
+
+  if (!token.isEmpty())
+    tokens << token;
+
+  return tokens;
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::addMessage (const shared_ptr<linphone::ChatMessage> &message) {
+  if (!mIsLoaded || mReadersCount > 0) {
+    mPendingMessages << message;
+    return;
+  }
+
+  const QString content = ::getMessageContent(message);
+  QStringList tokens = tokenize(content);
+  if (tokens.isEmpty())
+    return;
+
+  tokens.removeDuplicates();
+
+  // 1. Store the content.
+  const QByteArray data = content.toUtf8();
+  const qint64 offset = mContentsFile.size();
+  if (!mContentsFile.seek(offset) || mContentsFile.write(data) != data.size()) {
+    qWarning() << QStringLiteral("Unable to write message search contents.");
+    return;
+  }
+
+  // 2. Add the document.
+  const QString sipAddress = ::getSipAddress(message);
+
+  auto it = mSipAddressIds.find(sipAddress);
+  if (it == mSipAddressIds.end()) {
+    it = mSipAddressIds.insert(sipAddress, static_cast<quint32>(mData.sipAddresses.count()));
+    mData.sipAddresses << sipAddress;
+  }
+
+  Document document;
+  document.sipAddressId = *it;
+  document.time = static_cast<qint64>(message->getTime());
+  document.contentOffset = offset;
+  document.contentSize = static_cast<quint32>(data.size());
+  document.isOutgoing = message->isOutgoing();
+
+  const quint32 id = static_cast<quint32>(mData.documents.count());
+  mData.documents << document;
+
+  // 3. Ids are increasing, postings stay sorted.
+  for (const auto &token : tokens)
+    mData.postings[token] << id;
+
+  scheduleSave();
+}
+
+void ChatSearchIndex::removeMessage (const shared_ptr<linphone::ChatMessage> &message) {
+  if (!mIsLoaded || mReadersCount > 0) {
+    if (!mPendingMessages.removeOne(message))
+      mPendingRemovedMessages << message;
+    return;
+  }
+
+  const QString content = ::getMessageContent(message);
+  const QStringList tokens = tokenize(content);
+  if (tokens.isEmpty())
+    return;
+
+  auto it = mSipAddressIds.constFind(::getSipAddress(message));
+  if (it == mSipAddressIds.cend())
+    return;
+
+  // The message is one of the documents of its first token. The content is not read.
+  const quint32 sipAddressId = *it;
+  const qint64 time = static_cast<qint64>(message->getTime());
+  const quint32 contentSize = static_cast<quint32>(content.toUtf8().size());
+  const bool isOutgoing = message->isOutgoing();
+
+  for (quint32 id : mData.postings.value(tokens.first())) {
+    Document &document = mData.documents[static_cast<int>(id)];
+    if (
+      !document.removed &&
+      document.sipAddressId == sipAddressId &&
+      document.time == time &&
+      document.contentSize == contentSize &&
+      document.isOutgoing == isOutgoing
+    ) {
+      removeDocument(document);
+      return;
+    }
+  }
+}
+
+void ChatSearchIndex::removeChatRoom (const QString &sipAddress) {
+  if (!mIsLoaded || mReadersCount > 0) {
+    auto it = remove_if(mPendingMessages.begin(), mPendingMessages.end(), [&sipAddress](const shared_ptr<linphone::ChatMessage> &message) {
+      return ::getSipAddress(message) == sipAddress;
+    });
+    mPendingMessages.erase(it, mPendingMessages.end());
+    mPendingRemovedChatRooms << sipAddress;
+    return;
+  }
+
+  mBuildTasks.remove_if([&sipAddress](const BuildTask &task) {
+    return ::Utils::coreStringToAppString(task.chatRoom->getPeerAddress()->asStringUriOnly()) == sipAddress;
+  });
+
+  auto it = mSipAddressIds.constFind(sipAddress);
+  if (it == mSipAddressIds.cend())
+    return;
+
+  const quint32 sipAddressId = *it;
+  for (auto &document : mData.documents)
+    if (document.sipAddressId == sipAddressId && !document.removed)
+      removeDocument(document);
+}
+
+void ChatSearchIndex::removeDocument (Document &document) {
+  // Removed documents are skipped by the searches until the next compaction.
+  document.removed = true;
+  ++mRemovedCount;
+
+  scheduleSave();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::handlePendingChanges () {
+  for (const auto &sipAddress : mPendingRemovedChatRooms)
+    removeChatRoom(sipAddress);
+  for (const auto &message : mPendingMessages)
+    addMessage(message);
+  for (const auto &message : mPendingRemovedMessages)
+    removeMessage(message);
+
+  mPendingRemovedChatRooms.clear();
+  mPendingMessages.clear();
+  mPendingRemovedMessages.clear();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::addReader (const QFuture<void> &future) {
+  ++mReadersCount;
+
+  QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+  QObject::connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher] {
+    watcher->deleteLater();
+    if (--mReadersCount == 0)
+      handleReadersFinished();
+  });
+  watcher->setFuture(future);
+}
+
+void ChatSearchIndex::handleReadersFinished () {
+  if (mIsLoaded)
+    handlePendingChanges();
+
+  if (!mBuildTasks.empty())
+    mBuildTimer->start();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::handleLoaded () {
+  Data data = mLoadWatcher.result();
+
+  bool opened = mContentsFile.open(QIODevice::ReadWrite);
+  if (!opened)
+    qWarning() << QStringLiteral("Unable to open message search contents: `%1`.").arg(mContentsFile.fileName());
+
+  // Contents written after the last save are not referenced.
+  if (data.isBuilt && opened && mContentsFile.size() >= data.contentsSize) {
+    mData = data;
+    mContentsFile.resize(mData.contentsSize);
+  } else {
+    mData = Data();
+    mContentsFile.resize(0);
+  }
+
+  for (int i = 0; i < mData.sipAddresses.count(); ++i)
+    mSipAddressIds.insert(mData.sipAddresses[i], static_cast<quint32>(i));
+
+  mRemovedCount = static_cast<int>(count_if(mData.documents.cbegin(), mData.documents.cend(), [](const Document &document) {
+    return document.removed;
+  }));
+
+  // Without index, pending messages are read by the build.
+  if (!mData.isBuilt) {
+    mPendingRemovedChatRooms.clear();
+    mPendingMessages.clear();
+    mPendingRemovedMessages.clear();
+  }
+
+  mIsLoaded = true;
+  if (mReadersCount == 0)
+    handlePendingChanges();
+
+  emit indexChanged();
+
+  if (!mData.isBuilt)
+    startBuild();
+}
+
+void ChatSearchIndex::startBuild () {
+  qInfo() << QStringLiteral("Build message search index.");
+
+  for (const auto &chatRoom : CoreManager::getInstance()->getCore()->getChatRooms())
+    mBuildTasks.push_back({ chatRoom, chatRoom->getHistorySize(), 0 });
+
+  mBuildTimer->start();
+}
+
+void ChatSearchIndex::buildNextChunk () {
+  // Resumed when the searches are finished.
+  if (mReadersCount > 0)
+    return;
+
+  int n = 0;
+
+  while (n < BUILD_CHUNK_SIZE && !mBuildTasks.empty()) {
+    BuildTask &task = mBuildTasks.front();
+
+    // Messages are read from the oldest. Received messages are added at index 0.
+    const int end = task.chatRoom->getHistorySize() - 1 - task.offset;
+    const int count = min(task.count - task.offset, BUILD_CHUNK_SIZE - n);
+    if (end < 0 || count <= 0) {
+      mBuildTasks.pop_front();
+      continue;
+    }
+
+    list<shared_ptr<linphone::ChatMessage> > messages = task.chatRoom->getHistoryRange(max(end - count + 1, 0), end);
+    if (messages.empty()) {
+      mBuildTasks.pop_front();
+      continue;
+    }
+
+    for (const auto &message : messages)
+      addMessage(message);
+
+    task.offset += static_cast<int>(messages.size());
+    n += static_cast<int>(messages.size());
+  }
+
+  if (!mBuildTasks.empty()) {
+    mBuildTimer->start();
+    return;
+  }
+
+  qInfo() << QStringLiteral("Message search index built: %1 message(s).").arg(mData.documents.count());
+
+  mData.isBuilt = true;
+  mIsDirty = true;
+  save();
+
+  emit indexChanged();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::scheduleSave () {
+  mIsDirty = true;
+
+  // An unfinished build is restarted at the next launch.
+  if (mData.isBuilt && !mSaveTimer->isActive())
+    mSaveTimer->start();
+}
+
+void ChatSearchIndex::save () {
+  if (!mIsDirty || !mData.isBuilt)
+    return;
+
+  if (mSaveWatcher.isRunning() || mCompactWatcher.isRunning()) {
+    mSaveTimer->start();
+    return;
+  }
+
+  // The index is saved with the compacted contents.
+  if (needsCompaction()) {
+    compact();
+    return;
+  }
+
+  mContentsFile.flush();
+  mData.contentsSize = mContentsFile.size();
+  mIsDirty = false;
+
+  // Containers are implicitly shared, the copy is cheap while no change is applied.
+  mSaveWatcher.setFuture(QtConcurrent::run(&ChatSearchIndex::saveData, mIndexPath, mData));
+  addReader(mSaveWatcher.future());
+}
+
+bool ChatSearchIndex::needsCompaction () const {
+  return mRemovedCount >= COMPACTION_MIN_REMOVED_COUNT &&
+    mRemovedCount > mData.documents.count() * COMPACTION_REMOVED_RATIO;
+}
+
+void ChatSearchIndex::compact () {
+  qInfo() << QStringLiteral("Compact message search index: %1 removed message(s).").arg(mRemovedCount);
+
+  mContentsFile.flush();
+
+  // Changes are pending until the end, the searches still use the current contents.
+  mIsLoaded = false;
+  mCompactWatcher.setFuture(QtConcurrent::run(&ChatSearchIndex::compactData, mData, mContentsFile.fileName()));
+}
+
+void ChatSearchIndex::handleCompacted () {
+  Data data = mCompactWatcher.result();
+
+  const QString contentsPath = mContentsFile.fileName();
+  const QString compactedContentsPath = contentsPath + COMPACTED_CONTENTS_SUFFIX;
+
+  bool rebuild = false;
+  if (data.isBuilt) {
+    mContentsFile.close();
+
+    if (!QFile::remove(contentsPath)) {
+      qWarning() << QStringLiteral("Unable to replace message search contents: `%1`.").arg(contentsPath);
+      QFile::remove(compactedContentsPath);
+    } else if (!QFile::rename(compactedContentsPath, contentsPath)) {
+      qWarning() << QStringLiteral("Unable to replace message search contents: `%1`.").arg(contentsPath);
+      rebuild = true;
+    } else
+      mData = data;
+
+    if (!mContentsFile.open(QIODevice::ReadWrite)) {
+      qWarning() << QStringLiteral("Unable to open message search contents: `%1`.").arg(contentsPath);
+      rebuild = true;
+    }
+  }
+
+  // Not retried before new removals.
+  mRemovedCount = 0;
+
+  // The current contents are lost, the index is built again.
+  if (rebuild) {
+    mData = Data();
+    mSipAddressIds.clear();
+    mContentsFile.resize(0);
+    mPendingMessages.clear();
+    mPendingRemovedMessages.clear();
+    mPendingRemovedChatRooms.clear();
+    mIsLoaded = true;
+    startBuild();
+
+    emit indexChanged();
+    return;
+  }
+
+  mIsLoaded = true;
+  if (mReadersCount == 0)
+    handlePendingChanges();
+
+  mIsDirty = true;
+  save();
+
+  // Ids are renumbered.
+  emit indexChanged();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchIndex::handleChatModelCreated (const shared_ptr<ChatModel> &chatModel) {
+  ChatModel *ptr = chatModel.get();
+
+  QObject::connect(ptr, &ChatModel::messageSent, this, &ChatSearchIndex::addMessage);
+  QObject::connect(ptr, &ChatModel::messageRemoved, this, &ChatSearchIndex::removeMessage);
+  QObject::connect(ptr, &ChatModel::allEntriesRemoved, this, [this, ptr] {
+    removeChatRoom(ptr->getSipAddress());
+  });
+}
+
+// -----------------------------------------------------------------------------
+// Executed in a worker thread.
+// -----------------------------------------------------------------------------
+
+ChatSearchIndex::Data ChatSearchIndex::loadData (const QString &indexPath) {
+  QFile file(indexPath);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+    return Data();
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic, version;
+  stream >> magic >> version;
+  if (magic != INDEX_MAGIC || version != INDEX_VERSION) {
+    qWarning() << QStringLiteral("Unsupported message search index: `%1`.").arg(indexPath);
+    return Data();
+  }
+
+  Data data;
+  quint32 count;
+  stream >> data.sipAddresses >> data.contentsSize >> count;
+
+  // Avoid a huge allocation with a corrupted file.
+  if (stream.status() != QDataStream::Ok || count > static_cast<quint64>(file.size())) {
+    qWarning() << QStringLiteral("Invalid message search index: `%1`.").arg(indexPath);
+    return Data();
+  }
+
+  data.documents.resize(static_cast<int>(count));
+  for (auto &document : data.documents)
+    stream >> document.sipAddressId >> document.time >> document.contentOffset >>
+      document.contentSize >> document.isOutgoing >> document.removed;
+
+  stream >> data.postings;
+
+  if (stream.status() != QDataStream::Ok) {
+    qWarning() << QStringLiteral("Invalid message search index: `%1`.").arg(indexPath);
+    return Data();
+  }
+
+  data.isBuilt = true;
+  return data;
+}
+
+bool ChatSearchIndex::saveData (const QString &indexPath, const Data &data) {
+  QSaveFile file(indexPath);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << QStringLiteral("Unable to save message search index: `%1`.").arg(indexPath);
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  stream << quint32(INDEX_MAGIC) << quint32(INDEX_VERSION);
+  stream << data.sipAddresses << data.contentsSize << quint32(data.documents.count());
+
+  for (const auto &document : data.documents)
+    stream << document.sipAddressId << document.time << document.contentOffset <<
+      document.contentSize << document.isOutgoing << document.removed;
+
+  stream << data.postings;
+
+  if (stream.status() != QDataStream::Ok || !file.commit()) {
+    qWarning() << QStringLiteral("Unable to save message search index: `%1`.").arg(indexPath);
+    return false;
+  }
+
+  return true;
+}
+
+ChatSearchIndex::Data ChatSearchIndex::compactData (const Data &data, const QString &contentsPath) {
+  QFile source(contentsPath);
+  QFile destination(contentsPath + COMPACTED_CONTENTS_SUFFIX);
+  if (!source.open(QIODevice::ReadOnly) || !destination.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    qWarning() << QStringLiteral("Unable to compact message search contents: `%1`.").arg(contentsPath);
+    return Data();
+  }
+
+  // Ids are renumbered, the postings are computed again.
+  Data compactedData;
+  compactedData.sipAddresses = data.sipAddresses;
+
+  for (const auto &document : data.documents) {
+    if (document.removed)
+      continue;
+
+    QByteArray content;
+    if (source.seek(document.contentOffset))
+      content = source.read(document.contentSize);
+
+    Document compactedDocument = document;
+    compactedDocument.contentOffset = destination.pos();
+    if (
+      content.size() != static_cast<int>(document.contentSize) ||
+      destination.write(content) != content.size()
+    ) {
+      qWarning() << QStringLiteral("Unable to compact message search contents: `%1`.").arg(contentsPath);
+      destination.remove();
+      return Data();
+    }
+
+    QStringList tokens = tokenize(QString::fromUtf8(content));
+    tokens.removeDuplicates();
+
+    const quint32 id = static_cast<quint32>(compactedData.documents.count());
+    compactedData.documents << compactedDocument;
+    for (const auto &token : tokens)
+      compactedData.postings[token] << id;
+  }
+
+  if (!destination.flush()) {
+    qWarning() << QStringLiteral("Unable to compact message search contents: `%1`.").arg(contentsPath);
+    destination.remove();
+    return Data();
+  }
+
+  compactedData.contentsSize = destination.size();
+  compactedData.isBuilt = true;
+  return compactedData;
+}
+
+QVector<quint32> ChatSearchIndex::computeHits (const Data &data, const QStringList &tokens) {
+  if (tokens.isEmpty())
+    return QVector<quint32>();
+
+  // 1. Documents of each token. The last one is a prefix. (Query being typed.)
+  QList<QVector<quint32> > postings;
+  for (int i = 0; i < tokens.count() - 1; ++i) {
+    auto it = data.postings.constFind(tokens[i]);
+    if (it == data.postings.cend())
+      return QVector<quint32>();
+    postings << *it;
+  }
+
+  const QString &prefix = tokens.last();
+  const QVector<quint32> exactIds = data.postings.value(prefix);
+
+  // Tokens are sorted, the ones starting with the prefix are contiguous.
+  // Beyond the limit, the other words are ignored until the query is more precise.
+  QVector<quint32> prefixIds;
+  int termsCount = 0;
+  for (
+    auto it = data.postings.lowerBound(prefix);
+    it != data.postings.cend() && it.key().startsWith(prefix) && termsCount < MAX_PREFIX_TERMS;
+    ++it, ++termsCount
+  )
+    prefixIds += it.value();
+
+  if (prefixIds.isEmpty())
+    return QVector<quint32>();
+
+  sort(prefixIds.begin(), prefixIds.end());
+  prefixIds.erase(unique(prefixIds.begin(), prefixIds.end()), prefixIds.end());
+  postings << prefixIds;
+
+  // 2. Intersect, from the smallest list.
+  sort(postings.begin(), postings.end(), [](const QVector<quint32> &a, const QVector<quint32> &b) {
+    return a.count() < b.count();
+  });
+
+  QVector<quint32> ids = postings.first();
+  for (int i = 1; i < postings.count() && !ids.isEmpty(); ++i) {
+    QVector<quint32> intersection;
+    set_intersection(
+      ids.cbegin(), ids.cend(), postings[i].cbegin(), postings[i].cend(),
+      back_inserter(intersection)
+    );
+    ids = intersection;
+  }
+
+  // 3. Rank. Whole words first, then the most recent messages.
+  struct RankedHit {
+    quint32 id;
+    bool isExact;
+    qint64 time;
+  };
+
+  QVector<RankedHit> hits;
+  hits.reserve(ids.count());
+  for (quint32 id : ids) {
+    const Document &document = data.documents[static_cast<int>(id)];
+    if (!document.removed)
+      hits.push_back({ id, binary_search(exactIds.cbegin(), exactIds.cend(), id), document.time });
+  }
+
+  sort(hits.begin(), hits.end(), [](const RankedHit &a, const RankedHit &b) {
+    if (a.isExact != b.isExact)
+      return a.isExact;
+    return a.time > b.time;
+  });
+
+  QVector<quint32> result;
+  result.reserve(hits.count());
+  for (const auto &hit : hits)
+    result << hit.id;
+
+  return result;
+}
@@ -0,0 +1,148 @@
+/*
+ * ChatSearchIndex.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 10, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef CHAT_SEARCH_INDEX_H_
+#define CHAT_SEARCH_INDEX_H_
+
+#include <linphone++/linphone.hh>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+
+// =============================================================================
+// Inverted index of the messages of all chat rooms.
+// The index is persisted and message contents are stored in a separate file,
+// they are read only for the displayed hits.
+// =============================================================================
+
+class QTimer;
+
+class ChatModel;
+
+class ChatSearchIndex : public QObject {
+  Q_OBJECT;
+
+public:
+  struct Document {
+    quint32 sipAddressId = 0;
+    qint64 time = 0; // In seconds.
+    qint64 contentOffset = 0;
+    quint32 contentSize = 0;
+    bool isOutgoing = false;
+    bool removed = false;
+  };
+
+  struct Data {
+    QStringList sipAddresses;
+    QVector<Document> documents;
+    QMap<QString, QVector<quint32> > postings; // Sorted tokens => sorted document ids.
+    qint64 contentsSize = 0;
+    bool isBuilt = false;
+  };
+
+  struct Hit {
+    QString sipAddress;
+    QString content;
+    qint64 timestamp = 0; // In ms.
+    bool isOutgoing = false;
+  };
+
+  ChatSearchIndex (QObject *parent = Q_NULLPTR);
+  ~ChatSearchIndex ();
+
+  // Ranked ids of the matching documents. Computed in a worker thread.
+  QFuture<QVector<quint32> > search (const QString &query);
+
+  Hit getHit (quint32 id);
+
+  // Case and diacritic folded words.
+  static QStringList tokenize (const QString &text);
+
+signals:
+  // Previous hits are invalid. (Compacted or rebuilt index.)
+  void indexChanged ();
+
+private:
+  // A chat room to index and the number of its messages to read. (From the oldest.)
+  struct BuildTask {
+    std::shared_ptr<linphone::ChatRoom> chatRoom;
+    int count;
+    int offset;
+  };
+
+  void addMessage (const std::shared_ptr<linphone::ChatMessage> &message);
+  void removeMessage (const std::shared_ptr<linphone::ChatMessage> &message);
+  void removeChatRoom (const QString &sipAddress);
+  void removeDocument (Document &document);
+
+  void handlePendingChanges ();
+
+  void addReader (const QFuture<void> &future);
+  void handleReadersFinished ();
+
+  void handleLoaded ();
+  void startBuild ();
+  void buildNextChunk ();
+
+  void scheduleSave ();
+  void save ();
+
+  bool needsCompaction () const;
+  void compact ();
+  void handleCompacted ();
+
+  void handleChatModelCreated (const std::shared_ptr<ChatModel> &chatModel);
+
+  static Data loadData (const QString &indexPath);
+  static bool saveData (const QString &indexPath, const Data &data);
+  static Data compactData (const Data &data, const QString &contentsPath);
+  static QVector<quint32> computeHits (const Data &data, const QStringList &tokens);
+
+  Data mData;
+  QHash<QString, quint32> mSipAddressIds;
+
+  QFile mContentsFile;
+  QString mIndexPath;
+
+  // Changes received during the loading, the compaction or while workers read the data.
+  // (A change would detach the shared containers.)
+  bool mIsLoaded = false;
+  int mReadersCount = 0;
+  QList<std::shared_ptr<linphone::ChatMessage> > mPendingMessages;
+  QList<std::shared_ptr<linphone::ChatMessage> > mPendingRemovedMessages;
+  QStringList mPendingRemovedChatRooms;
+  QFutureWatcher<Data> mLoadWatcher;
+
+  int mRemovedCount = 0;
+  QFutureWatcher<Data> mCompactWatcher;
+
+  std::list<BuildTask> mBuildTasks;
+  QTimer *mBuildTimer = nullptr;
+
+  bool mIsDirty = false;
+  QTimer *mSaveTimer = nullptr;
+  QFutureWatcher<bool> mSaveWatcher;
+};
+
+#endif // CHAT_SEARCH_INDEX_H_
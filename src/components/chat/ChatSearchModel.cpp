@@ -0,0 +1,181 @@
+/*
+ * ChatSearchModel.cpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 10, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#include <QDateTime>
+#include <QTimer>
+
+#include "../core/CoreManager.hpp"
+
+#include "ChatSearchModel.hpp"
+
+// Wait the end of the typing. (In ms.)
+#define SEARCH_DELAY 200
+
+#define HITS_PAGE_SIZE 50
+
+using namespace std;
+
+// =============================================================================
+
+ChatSearchModel::ChatSearchModel (QObject *parent) : QAbstractListModel(parent) {
+  mSearchTimer = new QTimer(this);
+  mSearchTimer->setSingleShot(true);
+  mSearchTimer->setInterval(SEARCH_DELAY);
+  QObject::connect(mSearchTimer, &QTimer::timeout, this, &ChatSearchModel::search);
+
+  QObject::connect(
+    &mSearchWatcher, &QFutureWatcher<QVector<quint32> >::finished,
+    this, &ChatSearchModel::handleSearchFinished
+  );
+
+  QObject::connect(
+    CoreManager::getInstance()->getChatSearchIndex(), &ChatSearchIndex::indexChanged,
+    this, &ChatSearchModel::handleIndexChanged
+  );
+}
+
+int ChatSearchModel::rowCount (const QModelIndex &) const {
+  return mHits.count();
+}
+
+QHash<int, QByteArray> ChatSearchModel::roleNames () const {
+  QHash<int, QByteArray> roles;
+  roles[Roles::SipAddress] = "$sipAddress";
+  roles[Roles::Content] = "$content";
+  roles[Roles::Timestamp] = "$timestamp";
+  roles[Roles::IsOutgoing] = "$isOutgoing";
+  return roles;
+}
+
+QVariant ChatSearchModel::data (const QModelIndex &index, int role) const {
+  int row = index.row();
+
+  if (!index.isValid() || row < 0 || row >= mHits.count())
+    return QVariant();
+
+  const ChatSearchIndex::Hit &hit = mHits[row];
+
+  switch (role) {
+    case Roles::SipAddress:
+      return hit.sipAddress;
+    case Roles::Content:
+      return hit.content;
+    case Roles::Timestamp:
+      return QDateTime::fromMSecsSinceEpoch(hit.timestamp);
+    case Roles::IsOutgoing:
+      return hit.isOutgoing;
+  }
+
+  return QVariant();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchModel::loadMoreHits () {
+  int row = mHits.count();
+  int count = qMin(HITS_PAGE_SIZE, mHitIds.count() - row);
+  if (count <= 0)
+    return;
+
+  // Contents are read from the disk, only for the displayed hits.
+  ChatSearchIndex *index = CoreManager::getInstance()->getChatSearchIndex();
+
+  beginInsertRows(QModelIndex(), row, row + count - 1);
+  for (int i = row; i < row + count; ++i)
+    mHits << index->getHit(mHitIds[i]);
+  endInsertRows();
+}
+
+void ChatSearchModel::setFilter (const QString &filter) {
+  setQuery(filter);
+}
+
+// -----------------------------------------------------------------------------
+
+QString ChatSearchModel::getQuery () const {
+  return mQuery;
+}
+
+void ChatSearchModel::setQuery (const QString &query) {
+  if (mQuery == query)
+    return;
+
+  mQuery = query;
+  mSearchTimer->start();
+
+  emit queryChanged(query);
+  emit searchingChanged(true);
+}
+
+bool ChatSearchModel::getSearching () const {
+  return mSearchTimer->isActive() || mSearchWatcher.isRunning();
+}
+
+int ChatSearchModel::getHitsCount () const {
+  return mHitIds.count();
+}
+
+// -----------------------------------------------------------------------------
+
+void ChatSearchModel::search () {
+  // Restarted when the current search is finished.
+  if (mSearchWatcher.isRunning()) {
+    mSearchIsOutdated = true;
+    return;
+  }
+
+  mSearchIsOutdated = false;
+  mSearchWatcher.setFuture(CoreManager::getInstance()->getChatSearchIndex()->search(mQuery));
+
+  emit searchingChanged(true);
+}
+
+void ChatSearchModel::handleSearchFinished () {
+  if (mSearchIsOutdated) {
+    search();
+    return;
+  }
+
+  beginResetModel();
+  mHitIds = mSearchWatcher.result();
+  mHits.clear();
+  endResetModel();
+
+  loadMoreHits();
+
+  emit hitsCountChanged(mHitIds.count());
+  emit searchingChanged(getSearching());
+}
+
+void ChatSearchModel::handleIndexChanged () {
+  // Hit ids refer to the previous index.
+  beginResetModel();
+  mHitIds.clear();
+  mHits.clear();
+  endResetModel();
+
+  emit hitsCountChanged(0);
+
+  // A pending search reads the new index.
+  if (!mSearchTimer->isActive())
+    search();
+}
@@ -0,0 +1,88 @@
+/*
+ * ChatSearchModel.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 10, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef CHAT_SEARCH_MODEL_H_
+#define CHAT_SEARCH_MODEL_H_
+
+#include <QAbstractListModel>
+
+#include "ChatSearchIndex.hpp"
+
+// =============================================================================
+// Messages of all chat rooms matching a query. Hits are displayed page by page.
+// =============================================================================
+
+class ChatSearchModel : public QAbstractListModel {
+  Q_OBJECT;
+
+  Q_PROPERTY(QString query READ getQuery WRITE setQuery NOTIFY queryChanged);
+  Q_PROPERTY(bool searching READ getSearching NOTIFY searchingChanged);
+  Q_PROPERTY(int hitsCount READ getHitsCount NOTIFY hitsCountChanged);
+
+public:
+  enum Roles {
+    SipAddress = Qt::UserRole,
+    Content,
+    Timestamp,
+    IsOutgoing
+  };
+
+  ChatSearchModel (QObject *parent = Q_NULLPTR);
+  ~ChatSearchModel () = default;
+
+  int rowCount (const QModelIndex &index = QModelIndex()) const override;
+
+  QHash<int, QByteArray> roleNames () const override;
+  QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+  Q_INVOKABLE void loadMoreHits ();
+
+  // Used by the search boxes.
+  Q_INVOKABLE void setFilter (const QString &filter);
+
+signals:
+  void queryChanged (const QString &query);
+  void searchingChanged (bool status);
+  void hitsCountChanged (int count);
+
+private:
+  QString getQuery () const;
+  void setQuery (const QString &query);
+
+  bool getSearching () const;
+  int getHitsCount () const;
+
+  void search ();
+  void handleSearchFinished ();
+
+  void handleIndexChanged ();
+
+  QString mQuery;
+  QTimer *mSearchTimer = nullptr;
+  QFutureWatcher<QVector<quint32> > mSearchWatcher;
+  bool mSearchIsOutdated = false;
+
+  QVector<quint32> mHitIds;
+  QList<ChatSearchIndex::Hit> mHits;
+};
+
+#endif // CHAT_SEARCH_MODEL_H_
@@ -0,0 +1,305 @@
+/*
+ * FileTransferScheduler.cpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 12, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QTimer>
+
+#include "../../utils/Utils.hpp"
+#include "../core/CoreManager.hpp"
+
+#include "FileTransferScheduler.hpp"
+
+// Interval between two checks of the bandwidth budget when downloads are waiting.
+#define SCHEDULE_INTERVAL 500
+
+// Min interval between two throughput samples of a transfer.
+#define SPEED_SAMPLE_INTERVAL 250
+
+// Delay before considering a transfer without throughput sample as idle.
+#define SPEED_SAMPLE_TIMEOUT 1000
+
+// Max number of running downloads during a call.
+#define MAX_RUNNING_DOWNLOADS_IN_CALL 1
+
+using namespace std;
+
+// =============================================================================
+
+inline QString getSipAddress (const shared_ptr<linphone::ChatMessage> &message) {
+  return ::Utils::coreStringToAppString(message->getChatRoom()->getPeerAddress()->asStringUriOnly());
+}
+
+// -----------------------------------------------------------------------------
+
+FileTransferScheduler *FileTransferScheduler::mInstance = nullptr;
+
+FileTransferScheduler::FileTransferScheduler () : QObject(QCoreApplication::instance()) {
+  mScheduleTimer = new QTimer(this);
+  mScheduleTimer->setInterval(SCHEDULE_INTERVAL);
+  QObject::connect(mScheduleTimer, &QTimer::timeout, this, &FileTransferScheduler::schedule);
+
+  // Connected before the chat models, they replace the listener of the message.
+  QObject::connect(
+    CoreManager::getInstance()->getHandlers().get(), &CoreHandlers::messageReceived,
+    this, &FileTransferScheduler::handleMessageReceived
+  );
+}
+
+FileTransferScheduler::~FileTransferScheduler () {
+  mInstance = nullptr;
+}
+
+FileTransferScheduler *FileTransferScheduler::getInstance () {
+  if (!mInstance)
+    mInstance = new FileTransferScheduler();
+  return mInstance;
+}
+
+// -----------------------------------------------------------------------------
+
+void FileTransferScheduler::download (const shared_ptr<linphone::ChatMessage> &message, Priority priority) {
+  auto transferIt = mTransfers.constFind(message.get());
+  if (transferIt != mTransfers.cend() && transferIt->message)
+    return;
+
+  const QString sipAddress = ::getSipAddress(message);
+  if (priority == IdlePriority && mVisibleChatRooms.contains(sipAddress))
+    priority = VisiblePriority;
+
+  // Already pending, raise the priority if necessary.
+  bool queued = false;
+  for (auto it = mPendingDownloads.begin(); it != mPendingDownloads.end(); ++it)
+    if (it->message == message) {
+      if (it->priority >= priority)
+        return;
+
+      mPendingDownloads.erase(it);
+      queued = true;
+      break;
+    }
+
+  insertPendingDownload({ message, sipAddress, priority });
+  if (!queued)
+    emit queuedChanged(message, true);
+
+  schedule();
+}
+
+void FileTransferScheduler::cancel (const shared_ptr<linphone::ChatMessage> &message) {
+  auto it = find_if(mPendingDownloads.begin(), mPendingDownloads.end(), [&message](const PendingDownload &download) {
+    return download.message == message;
+  });
+  if (it != mPendingDownloads.end()) {
+    mPendingDownloads.erase(it);
+    emit queuedChanged(message, false);
+    return;
+  }
+
+  auto transferIt = mTransfers.constFind(message.get());
+  if (transferIt != mTransfers.cend() && transferIt->message)
+    message->cancelFileTransfer();
+}
+
+bool FileTransferScheduler::isQueued (const shared_ptr<linphone::ChatMessage> &message) const {
+  return any_of(mPendingDownloads.cbegin(), mPendingDownloads.cend(), [&message](const PendingDownload &download) {
+    return download.message == message;
+  });
+}
+
+void FileTransferScheduler::addVisibleChatRoom (const QString &sipAddress) {
+  if (++mVisibleChatRooms[sipAddress] == 1)
+    updateVisiblePriorities(sipAddress);
+}
+
+void FileTransferScheduler::removeVisibleChatRoom (const QString &sipAddress) {
+  auto it = mVisibleChatRooms.find(sipAddress);
+  if (it == mVisibleChatRooms.end() || --*it > 0)
+    return;
+
+  mVisibleChatRooms.erase(it);
+  updateVisiblePriorities(sipAddress);
+}
+
+// -----------------------------------------------------------------------------
+
+void FileTransferScheduler::handleFileTransferProgress (const shared_ptr<linphone::ChatMessage> &message, size_t offset) {
+  TransferStats &stats = mTransfers[message.get()];
+
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  if (stats.startTime == 0)
+    stats.startTime = now;
+
+  if (stats.lastUpdate == 0) {
+    stats.lastUpdate = now;
+    stats.lastOffset = offset;
+    return;
+  }
+
+  const qint64 elapsed = now - stats.lastUpdate;
+  if (elapsed < SPEED_SAMPLE_INTERVAL)
+    return;
+
+  stats.speed = (offset - stats.lastOffset) * 1000.0 / elapsed;
+  stats.lastUpdate = now;
+  stats.lastOffset = offset;
+}
+
+void FileTransferScheduler::handleFileTransferEnded (const shared_ptr<linphone::ChatMessage> &message) {
+  auto it = mTransfers.find(message.get());
+  if (it == mTransfers.end())
+    return;
+
+  if (it->message)
+    --mRunningDownloadsCount;
+  mTransfers.erase(it);
+
+  schedule();
+}
+
+// -----------------------------------------------------------------------------
+
+void FileTransferScheduler::handleMessageReceived (const shared_ptr<linphone::ChatMessage> &message) {
+  shared_ptr<const linphone::Content> content = message->getFileTransferInformation();
+  if (!content || message->isOutgoing())
+    return;
+
+  int limit = CoreManager::getInstance()->getSettingsModel()->getAutoDownloadSizeLimit();
+  if (limit <= 0 || content->getSize() > static_cast<size_t>(limit))
+    return;
+
+  message->setListener(ChatModel::getDetachedMessageHandlers());
+  download(message, IdlePriority);
+}
+
+// -----------------------------------------------------------------------------
+
+bool FileTransferScheduler::canStartDownload (Priority priority) const {
+  shared_ptr<linphone::Core> core = CoreManager::getInstance()->getCore();
+  SettingsModel *settings = CoreManager::getInstance()->getSettingsModel();
+
+  // Keep the link for the call media.
+  const bool inCall = core->getCallsNb() > 0;
+  if (inCall && priority != UserPriority)
+    return false;
+
+  const int maxRunningDownloads = inCall
+    ? MAX_RUNNING_DOWNLOADS_IN_CALL
+    : settings->getMaxFileDownloads();
+  if (mRunningDownloadsCount >= maxRunningDownloads)
+    return false;
+
+  const int bandwidth = settings->getFileTransferBandwidth(); // In KiB/s.
+  if (bandwidth <= 0)
+    return true;
+
+  // The throughput of a transfer can't be limited once started. A download is
+  // started only if all transfers are measured and under the budget.
+  const qint64 now = QDateTime::currentMSecsSinceEpoch();
+  double speed = 0;
+  for (const auto &stats : mTransfers) {
+    if (stats.speed >= 0)
+      speed += stats.speed;
+    else if (now - stats.startTime < SPEED_SAMPLE_TIMEOUT)
+      return false;
+  }
+
+  return speed < bandwidth * 1024.0;
+}
+
+bool FileTransferScheduler::startDownload (const shared_ptr<linphone::ChatMessage> &message) {
+  // The file path is computed only now, queued files can have the same name.
+  bool soFarSoGood;
+  const QString safeFilePath = ::Utils::getSafeFilePath(
+      QStringLiteral("%1%2")
+      .arg(CoreManager::getInstance()->getSettingsModel()->getDownloadFolder())
+      .arg(::Utils::coreStringToAppString(message->getFileTransferInformation()->getName())),
+      &soFarSoGood
+    );
+
+  if (!soFarSoGood) {
+    qWarning() << QStringLiteral("Unable to create safe file path for: %1.").arg(safeFilePath);
+    return false;
+  }
+
+  message->setFileTransferFilepath(::Utils::appStringToCoreString(safeFilePath));
+  if (message->downloadFile() < 0) {
+    qWarning() << QStringLiteral("Unable to download file: %1.").arg(safeFilePath);
+    return false;
+  }
+
+  TransferStats &stats = mTransfers[message.get()];
+  stats.message = message;
+  stats.startTime = QDateTime::currentMSecsSinceEpoch();
+  ++mRunningDownloadsCount;
+
+  return true;
+}
+
+void FileTransferScheduler::insertPendingDownload (const PendingDownload &download) {
+  auto it = find_if(mPendingDownloads.begin(), mPendingDownloads.end(), [&download](const PendingDownload &pendingDownload) {
+    return pendingDownload.priority < download.priority;
+  });
+  mPendingDownloads.insert(it, download);
+}
+
+void FileTransferScheduler::updateVisiblePriorities (const QString &sipAddress) {
+  const Priority priority = mVisibleChatRooms.contains(sipAddress) ? VisiblePriority : IdlePriority;
+
+  // Move the automatic downloads of the chat room to the end of their new tier.
+  QList<PendingDownload> downloads;
+  for (auto it = mPendingDownloads.begin(); it != mPendingDownloads.end(); )
+    if (it->priority != UserPriority && it->priority != priority && it->sipAddress == sipAddress) {
+      downloads << *it;
+      it = mPendingDownloads.erase(it);
+    } else
+      ++it;
+
+  for (auto &download : downloads) {
+    download.priority = priority;
+    insertPendingDownload(download);
+  }
+
+  if (!downloads.isEmpty())
+    schedule();
+}
+
+void FileTransferScheduler::schedule () {
+  while (!mPendingDownloads.isEmpty() && canStartDownload(mPendingDownloads.first().priority)) {
+    const PendingDownload download = mPendingDownloads.takeFirst();
+    emit queuedChanged(download.message, false);
+
+    // Automatic downloads are not restarted.
+    if (
+      download.priority == UserPriority ||
+      download.message->getState() != linphone::ChatMessageStateFileTransferDone
+    )
+      startDownload(download.message);
+  }
+
+  if (mPendingDownloads.isEmpty())
+    mScheduleTimer->stop();
+  else if (!mScheduleTimer->isActive())
+    mScheduleTimer->start();
+}
@@ -0,0 +1,112 @@
+/*
+ * FileTransferScheduler.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 12, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef FILE_TRANSFER_SCHEDULER_H_
+#define FILE_TRANSFER_SCHEDULER_H_
+
+#include <linphone++/linphone.hh>
+#include <QHash>
+#include <QObject>
+
+// =============================================================================
+// Queue of the file downloads of all chat rooms.
+// A download is started only if the number of running downloads and the
+// measured throughput of all transfers are under the configured limits.
+// Automatic downloads of the displayed chat rooms are started first.
+// =============================================================================
+
+class QTimer;
+
+class FileTransferScheduler : public QObject {
+  Q_OBJECT;
+
+public:
+  enum Priority {
+    IdlePriority, // Automatic download of small files. Started only when there is no call.
+    VisiblePriority, // Automatic download in a displayed chat room.
+    UserPriority // Requested by the user.
+  };
+
+  ~FileTransferScheduler ();
+
+  // The message listener must be set, it must forward the progress and the state changes.
+  void download (const std::shared_ptr<linphone::ChatMessage> &message, Priority priority);
+  void cancel (const std::shared_ptr<linphone::ChatMessage> &message);
+
+  // Waiting for a download slot.
+  bool isQueued (const std::shared_ptr<linphone::ChatMessage> &message) const;
+
+  // A chat room can be displayed by several views.
+  void addVisibleChatRoom (const QString &sipAddress);
+  void removeVisibleChatRoom (const QString &sipAddress);
+
+  // Uploads are measured too, they share the bandwidth budget.
+  void handleFileTransferProgress (const std::shared_ptr<linphone::ChatMessage> &message, size_t offset);
+  void handleFileTransferEnded (const std::shared_ptr<linphone::ChatMessage> &message);
+
+  static FileTransferScheduler *getInstance ();
+
+signals:
+  void queuedChanged (const std::shared_ptr<linphone::ChatMessage> &message, bool status);
+
+private:
+  struct PendingDownload {
+    std::shared_ptr<linphone::ChatMessage> message;
+    QString sipAddress;
+    Priority priority;
+  };
+
+  struct TransferStats {
+    std::shared_ptr<linphone::ChatMessage> message; // Set for the scheduled downloads only.
+
+    qint64 startTime = 0; // In ms.
+    qint64 lastUpdate = 0; // In ms.
+    quint64 lastOffset = 0;
+    double speed = -1; // In bytes/s, -1 if unknown.
+  };
+
+  FileTransferScheduler ();
+
+  // Download the file of a received message if it's under the auto download size limit.
+  // Messages are received even if their chat room is not displayed.
+  void handleMessageReceived (const std::shared_ptr<linphone::ChatMessage> &message);
+
+  bool canStartDownload (Priority priority) const;
+  bool startDownload (const std::shared_ptr<linphone::ChatMessage> &message);
+
+  void insertPendingDownload (const PendingDownload &download);
+  void updateVisiblePriorities (const QString &sipAddress);
+
+  void schedule ();
+
+  QList<PendingDownload> mPendingDownloads; // Sorted by priority. (Highest first.)
+  QHash<QString, int> mVisibleChatRooms; // Sip address => number of views.
+  QHash<const void *, TransferStats> mTransfers;
+  int mRunningDownloadsCount = 0;
+
+  // Wake up the queue when the throughput decreases.
+  QTimer *mScheduleTimer = nullptr;
+
+  static FileTransferScheduler *mInstance;
+};
+
+#endif // FILE_TRANSFER_SCHEDULER_H_
@@ -0,0 +1,460 @@
+/*
+ * ThumbnailGenerator.cpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 4, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent>
+#include <QTimer>
+
+#include "../../app/paths/Paths.hpp"
+#include "../../utils/QExifImageHeader.h"
+#include "../../utils/Utils.hpp"
+#include "../core/CoreManager.hpp"
+
+#include "ThumbnailGenerator.hpp"
+
+#define THUMBNAIL_IMAGE_FILE_HEIGHT 100
+#define THUMBNAIL_IMAGE_FILE_WIDTH 100
+
+// Max relative difference between the image ratio and the EXIF thumbnail ratio.
+#define EMBEDDED_THUMBNAIL_MAX_RATIO_DELTA 0.02
+
+// Decoding is memory hungry, keep a few workers.
+#define MAX_RUNNING_REQUESTS 2
+
+// Oldest requests are dropped beyond this limit.
+#define MAX_PENDING_REQUESTS 64
+
+// Max size of the thumbnails directory. (In bytes.)
+#define THUMBNAILS_MAX_SIZE 52428800
+
+// First sweep after startup, then periodic sweeps. (In ms.)
+#define THUMBNAILS_SWEEP_DELAY 60000
+#define THUMBNAILS_SWEEP_INTERVAL 86400000
+
+// Number of messages read per event loop iteration during a sweep.
+#define THUMBNAILS_SWEEP_PAGE_SIZE 200
+
+using namespace std;
+
+// =============================================================================
+
+inline QString getFileId (const shared_ptr<linphone::ChatMessage> &message) {
+  return ::Utils::coreStringToAppString(message->getAppdata()).section(':', 0, 0);
+}
+
+// Hash of the whole content. Executed in a worker thread, the file is streamed.
+inline QString computeFileId (const QString &imagePath) {
+  QFile file(imagePath);
+  if (!file.open(QIODevice::ReadOnly))
+    return QString();
+
+  QCryptographicHash hash(QCryptographicHash::Sha1);
+  if (!hash.addData(&file))
+    return QString();
+
+  return QStringLiteral("%1.jpg").arg(QString::fromLatin1(hash.result().toHex()));
+}
+
+inline QImage getEmbeddedThumbnail (const QExifImageHeader &exifImageHeader, const QSize &imageSize, const QSize &thumbnailSize) {
+  if (!imageSize.isValid())
+    return QImage();
+
+  QImage thumbnail = exifImageHeader.thumbnail();
+  if (thumbnail.isNull())
+    return QImage();
+
+  // Compare the unrotated sizes.
+  QSize embeddedSize = thumbnail.size();
+  if (!exifImageHeader.thumbnailOrientation().isNull() && exifImageHeader.thumbnailOrientation().toShort() >= 5)
+    embeddedSize.transpose();
+
+  const QSize targetSize = imageSize.scaled(thumbnailSize, Qt::KeepAspectRatio);
+  if (embeddedSize.width() < targetSize.width() || embeddedSize.height() < targetSize.height())
+    return QImage();
+
+  // Some cameras use a fixed thumbnail ratio with black bars.
+  const double imageRatio = double(imageSize.width()) / imageSize.height();
+  const double embeddedRatio = double(embeddedSize.width()) / embeddedSize.height();
+  if (qAbs(imageRatio - embeddedRatio) > EMBEDDED_THUMBNAIL_MAX_RATIO_DELTA * imageRatio)
+    return QImage();
+
+  return thumbnail;
+}
+
+// -----------------------------------------------------------------------------
+
+ThumbnailGenerator *ThumbnailGenerator::mInstance = nullptr;
+
+ThumbnailGenerator::ThumbnailGenerator () : QObject(QCoreApplication::instance()) {
+  mThumbnailsPath = ::Utils::coreStringToAppString(Paths::getThumbnailsDirPath());
+
+  mThreadPool = new QThreadPool(this);
+  mThreadPool->setMaxThreadCount(MAX_RUNNING_REQUESTS);
+
+  mSweepTimer = new QTimer(this);
+  mSweepTimer->setSingleShot(true);
+  QObject::connect(mSweepTimer, &QTimer::timeout, this, &ThumbnailGenerator::sweepNextChatRoom);
+}
+
+ThumbnailGenerator::~ThumbnailGenerator () {
+  mThreadPool->waitForDone();
+  mInstance = nullptr;
+}
+
+// -----------------------------------------------------------------------------
+
+int ThumbnailGenerator::generate (const shared_ptr<linphone::ChatMessage> &message, const QString &imagePath) {
+  int id = ++mLastRequestId;
+
+  if (mPendingRequests.count() >= MAX_PENDING_REQUESTS) {
+    int droppedId = mPendingRequests.dequeue().first;
+    mRequestMessages.remove(droppedId);
+    qWarning() << QStringLiteral("Too many pending thumbnails, request %1 dropped.").arg(droppedId);
+
+    // Signal it later, the caller doesn't know the id yet if it's the current request.
+    QTimer::singleShot(0, this, [this, droppedId] {
+      emit thumbnailGenerated(droppedId, QString());
+    });
+  }
+
+  mPendingRequests.enqueue(qMakePair(id, imagePath));
+  mRequestMessages.insert(id, message);
+  startPendingRequests();
+
+  return id;
+}
+
+void ThumbnailGenerator::cancel (const shared_ptr<linphone::ChatMessage> &message) {
+  // The request can't be stopped, the result is ignored on reception.
+  for (auto &requestMessage : mRequestMessages)
+    if (requestMessage == message)
+      requestMessage = nullptr;
+}
+
+void ThumbnailGenerator::ref (const QString &fileId, time_t time) {
+  if (fileId.isEmpty())
+    return;
+
+  if (mRefsAreKnown) {
+    ThumbnailRefs &refs = mRefs[fileId];
+    ++refs.count;
+    refs.lastUse = qMax(refs.lastUse, time);
+  }
+
+  // Not evicted by the current sweep, the message is unknown.
+  if (mSweeping) {
+    ThumbnailRefs &refs = mSweepRefs[fileId];
+    ++refs.count;
+    refs.lastUse = qMax(refs.lastUse, time);
+  }
+}
+
+void ThumbnailGenerator::unref (const QString &fileId) {
+  // Without a valid count, the file is removed by the next sweep.
+  if (fileId.isEmpty() || !mRefsAreKnown || mSweeping)
+    return;
+
+  auto it = mRefs.find(fileId);
+  if (it == mRefs.end() || --it->count > 0)
+    return;
+
+  mRefs.erase(it);
+
+  // A worker can reuse the file for a new message, see `createThumbnail`.
+  QMutexLocker locker(&mFilesMutex);
+  if (mUnreferencedCreations.contains(fileId))
+    return;
+
+  QString thumbnailPath = mThumbnailsPath + fileId;
+  if (!QFile::remove(thumbnailPath))
+    qWarning() << QStringLiteral("Unable to remove `%1`.").arg(thumbnailPath);
+}
+
+bool ThumbnailGenerator::exists (const QString &fileId) const {
+  return QFileInfo::exists(mThumbnailsPath + fileId);
+}
+
+void ThumbnailGenerator::scheduleSweep () {
+  if (!mSweeping && !mSweepTimer->isActive())
+    mSweepTimer->start(THUMBNAILS_SWEEP_DELAY);
+}
+
+ThumbnailGenerator *ThumbnailGenerator::getInstance () {
+  if (!mInstance)
+    mInstance = new ThumbnailGenerator();
+  return mInstance;
+}
+
+// -----------------------------------------------------------------------------
+
+void ThumbnailGenerator::startPendingRequests () {
+  while (mRunningRequestsCount < MAX_RUNNING_REQUESTS && !mPendingRequests.isEmpty()) {
+    const QPair<int, QString> request = mPendingRequests.dequeue();
+    const int id = request.first;
+
+    QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(this);
+    QObject::connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, id] {
+      watcher->deleteLater();
+      handleRequestFinished(id, watcher->result());
+    });
+
+    ++mRunningRequestsCount;
+    watcher->setFuture(
+      QtConcurrent::run(mThreadPool, [this, request] {
+        return createThumbnail(request.second);
+      })
+    );
+  }
+}
+
+void ThumbnailGenerator::handleRequestFinished (int id, const QString &fileId) {
+  --mRunningRequestsCount;
+  startPendingRequests();
+
+  shared_ptr<linphone::ChatMessage> message = mRequestMessages.take(id);
+
+  // Unused thumbnails are removed by the next sweep.
+  if (!fileId.isEmpty() && message) {
+    // Keep the download path of received files.
+    QString downloadPath = ::Utils::coreStringToAppString(message->getAppdata()).section(':', 1);
+    message->setAppdata(::Utils::appStringToCoreString(
+      downloadPath.isEmpty() ? fileId : fileId + ':' + downloadPath
+    ));
+    ref(fileId, message->getTime());
+  }
+
+  if (!fileId.isEmpty())
+    releaseCreation(fileId);
+
+  emit thumbnailGenerated(id, message ? fileId : QString());
+}
+
+// -----------------------------------------------------------------------------
+
+void ThumbnailGenerator::sweepNextChatRoom () {
+  if (!mSweeping) {
+    qInfo() << QStringLiteral("Sweep thumbnails.");
+
+    mSweeping = true;
+    mSweepStartTime = QDateTime::currentMSecsSinceEpoch();
+    mSweepChatRooms = CoreManager::getInstance()->getCore()->getChatRooms();
+  }
+
+  if (mSweepChatRooms.empty()) {
+    finishSweep();
+    return;
+  }
+
+  // Read one page of the current chat room. (From the newest to the oldest.)
+  shared_ptr<linphone::ChatRoom> chatRoom = mSweepChatRooms.front();
+  const int historySize = chatRoom->getHistorySize();
+
+  // Removed messages shift the older ones, read again the shifted ones.
+  // A message counted twice is only kept longer.
+  if (mSweepHistorySize != -1 && historySize < mSweepHistorySize)
+    mSweepOffset = qMax(0, mSweepOffset - (mSweepHistorySize - historySize));
+  mSweepHistorySize = historySize;
+
+  if (mSweepOffset < historySize) {
+    for (const auto &message : chatRoom->getHistoryRange(mSweepOffset, mSweepOffset + THUMBNAILS_SWEEP_PAGE_SIZE - 1)) {
+      QString fileId = ::getFileId(message);
+      if (fileId.isEmpty())
+        continue;
+
+      ThumbnailRefs &refs = mSweepRefs[fileId];
+      ++refs.count;
+      refs.lastUse = qMax(refs.lastUse, message->getTime());
+    }
+    mSweepOffset += THUMBNAILS_SWEEP_PAGE_SIZE;
+  }
+
+  if (mSweepOffset >= historySize) {
+    mSweepChatRooms.pop_front();
+    mSweepOffset = 0;
+    mSweepHistorySize = -1;
+  }
+
+  mSweepTimer->start(0);
+}
+
+void ThumbnailGenerator::finishSweep () {
+  QDir dir(mThumbnailsPath);
+  qint64 totalSize = 0;
+  int removedCount = 0;
+
+  // Remove orphans. Recent files can be used by messages not yet saved.
+  QMutexLocker locker(&mFilesMutex);
+  const QDateTime sweepStartTime = QDateTime::fromMSecsSinceEpoch(mSweepStartTime);
+  for (const QFileInfo &info : dir.entryInfoList(QDir::Files)) {
+    if (
+      mSweepRefs.contains(info.fileName()) ||
+      mUnreferencedCreations.contains(info.fileName()) ||
+      info.lastModified() >= sweepStartTime
+    )
+      totalSize += info.size();
+    else if (QFile::remove(info.filePath()))
+      ++removedCount;
+    else
+      qWarning() << QStringLiteral("Unable to remove `%1`.").arg(info.filePath());
+  }
+
+  if (totalSize > THUMBNAILS_MAX_SIZE)
+    evictThumbnails(totalSize);
+
+  locker.unlock();
+
+  mRefs = mSweepRefs;
+  mRefsAreKnown = true;
+
+  mSweeping = false;
+  mSweepRefs.clear();
+
+  qInfo() << QStringLiteral("Thumbnails swept: %1 orphan(s) removed, %2 bytes used.")
+    .arg(removedCount).arg(totalSize);
+
+  mSweepTimer->start(THUMBNAILS_SWEEP_INTERVAL);
+}
+
+void ThumbnailGenerator::evictThumbnails (qint64 &totalSize) {
+  const QDateTime sweepStartTime = QDateTime::fromMSecsSinceEpoch(mSweepStartTime);
+
+  QList<QString> fileIds = mSweepRefs.keys();
+  sort(fileIds.begin(), fileIds.end(), [this](const QString &a, const QString &b) {
+    return mSweepRefs.value(a).lastUse < mSweepRefs.value(b).lastUse;
+  });
+
+  for (const QString &fileId : fileIds) {
+    if (totalSize <= THUMBNAILS_MAX_SIZE)
+      break;
+
+    // Recent files can be used by messages created during the sweep.
+    QFileInfo info(mThumbnailsPath + fileId);
+    if (info.lastModified() >= sweepStartTime || mUnreferencedCreations.contains(fileId))
+      continue;
+
+    qint64 size = info.size();
+    if (info.exists() && !QFile::remove(info.filePath())) {
+      qWarning() << QStringLiteral("Unable to remove `%1`.").arg(info.filePath());
+      continue;
+    }
+
+    totalSize -= size;
+    mSweepRefs.remove(fileId);
+
+    // The messages keep the file id, the thumbnail is created again when they are displayed.
+  }
+}
+
+// Called from the main thread and the workers.
+void ThumbnailGenerator::releaseCreation (const QString &fileId) {
+  QMutexLocker locker(&mFilesMutex);
+  auto it = mUnreferencedCreations.find(fileId);
+  if (it != mUnreferencedCreations.end() && --*it <= 0)
+    mUnreferencedCreations.erase(it);
+}
+
+// -----------------------------------------------------------------------------
+// Executed in a worker thread.
+// -----------------------------------------------------------------------------
+
+QString ThumbnailGenerator::createThumbnail (const QString &imagePath) {
+  QImageReader reader(imagePath);
+  if (!reader.canRead())
+    return QString();
+
+  // Already created for the same content.
+  const QString fileId = ::computeFileId(imagePath);
+  if (fileId.isEmpty())
+    return QString();
+
+  // The file can't be removed until the result is referenced on the main thread.
+  {
+    QMutexLocker locker(&mFilesMutex);
+    ++mUnreferencedCreations[fileId];
+    if (QFileInfo::exists(mThumbnailsPath + fileId))
+      return fileId;
+  }
+
+  const QSize thumbnailSize(THUMBNAIL_IMAGE_FILE_WIDTH, THUMBNAIL_IMAGE_FILE_HEIGHT);
+  const QSize imageSize = reader.size();
+
+  // Only the APPn segments of a JPEG are read here.
+  int rotation = 0;
+  QImage thumbnail;
+  QExifImageHeader exifImageHeader;
+  if (exifImageHeader.loadFromJpeg(imagePath)) {
+    rotation = (int) exifImageHeader.value(QExifImageHeader::ImageTag::Orientation).toShort();
+
+    // Use the embedded thumbnail if it's big enough.
+    thumbnail = ::getEmbeddedThumbnail(exifImageHeader, imageSize, thumbnailSize);
+    if (!thumbnail.isNull() && !exifImageHeader.thumbnailOrientation().isNull())
+      rotation = 0; // Already applied.
+  }
+
+  if (thumbnail.isNull()) {
+    // Decode directly at the thumbnail size if the format supports it. (JPEG, ...)
+    if (imageSize.isValid())
+      reader.setScaledSize(imageSize.scaled(thumbnailSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+
+    thumbnail = reader.read();
+    if (thumbnail.isNull()) {
+      releaseCreation(fileId);
+      return QString();
+    }
+  }
+
+  if (thumbnail.width() > THUMBNAIL_IMAGE_FILE_WIDTH || thumbnail.height() > THUMBNAIL_IMAGE_FILE_HEIGHT)
+    thumbnail = thumbnail.scaled(thumbnailSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+  if (rotation != 0) {
+    QTransform transform;
+    if (rotation == 3 || rotation == 4) {
+      transform.rotate(180);
+    } else if (rotation == 5 || rotation == 6) {
+      transform.rotate(90);
+    } else if (rotation == 7 || rotation == 8) {
+      transform.rotate(-90);
+    }
+    thumbnail = thumbnail.transformed(transform);
+    if (rotation == 2 || rotation == 4 || rotation == 5 || rotation == 7) {
+      thumbnail = thumbnail.mirrored(true, false);
+    }
+  }
+
+  // Another worker can create the same thumbnail, the file is replaced atomically.
+  QSaveFile file(mThumbnailsPath + fileId);
+  if (!file.open(QIODevice::WriteOnly) || !thumbnail.save(&file, "jpg", 100) || !file.commit()) {
+    qWarning() << QStringLiteral("Unable to create thumbnail of: `%1`.").arg(imagePath);
+    releaseCreation(fileId);
+    return QString();
+  }
+
+  return fileId;
+}
@@ -0,0 +1,120 @@
+/*
+ * ThumbnailGenerator.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 4, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef THUMBNAIL_GENERATOR_H_
+#define THUMBNAIL_GENERATOR_H_
+
+#include <linphone++/linphone.hh>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+
+// =============================================================================
+// Create the thumbnails of image files in worker threads.
+// Thumbnails are named by the hash of the image content and shared by
+// the messages which reference them in their appdata.
+// =============================================================================
+
+class QThreadPool;
+class QTimer;
+
+class ThumbnailGenerator : public QObject {
+  Q_OBJECT;
+
+public:
+  ~ThumbnailGenerator ();
+
+  // Returns a request id. The result is signaled by `thumbnailGenerated`.
+  // The file id is written in the appdata of the message, even if no chat model uses it.
+  int generate (const std::shared_ptr<linphone::ChatMessage> &message, const QString &imagePath);
+
+  // The thumbnail is still created but not set on the message.
+  void cancel (const std::shared_ptr<linphone::ChatMessage> &message);
+
+  // `time` is the time of the message which uses the thumbnail.
+  void ref (const QString &fileId, time_t time);
+  void unref (const QString &fileId);
+
+  // False if the thumbnail was evicted or removed.
+  bool exists (const QString &fileId) const;
+
+  // Count the references of all messages, remove the orphans and
+  // evict the least recently used thumbnails beyond the size limit.
+  void scheduleSweep ();
+
+  static ThumbnailGenerator *getInstance ();
+
+signals:
+  // `fileId` is empty if the thumbnail can't be created.
+  void thumbnailGenerated (int id, const QString &fileId);
+
+private:
+  struct ThumbnailRefs {
+    int count = 0;
+    time_t lastUse = 0;
+  };
+
+  ThumbnailGenerator ();
+
+  void startPendingRequests ();
+  void handleRequestFinished (int id, const QString &fileId);
+
+  void sweepNextChatRoom ();
+  void finishSweep ();
+  void evictThumbnails (qint64 &totalSize);
+
+  // Executed in a worker thread.
+  QString createThumbnail (const QString &imagePath);
+  void releaseCreation (const QString &fileId);
+
+  QString mThumbnailsPath;
+  QThreadPool *mThreadPool = nullptr;
+
+  QQueue<QPair<int, QString> > mPendingRequests;
+  QHash<int, std::shared_ptr<linphone::ChatMessage> > mRequestMessages;
+  int mRunningRequestsCount = 0;
+  int mLastRequestId = 0;
+
+  // Thumbnails returned by a worker and not yet referenced, they must not be removed.
+  // Guards the removals of the thumbnail files.
+  QMutex mFilesMutex;
+  QHash<QString, int> mUnreferencedCreations;
+
+  // Valid only after the first sweep.
+  QHash<QString, ThumbnailRefs> mRefs;
+  bool mRefsAreKnown = false;
+
+  // Sweep in progress, one page of messages is processed per event loop iteration.
+  QTimer *mSweepTimer = nullptr;
+  bool mSweeping = false;
+  qint64 mSweepStartTime = 0;
+  std::list<std::shared_ptr<linphone::ChatRoom> > mSweepChatRooms;
+  int mSweepOffset = 0; // In the history of the first chat room.
+  int mSweepHistorySize = -1;
+  QHash<QString, ThumbnailRefs> mSweepRefs;
+
+  static ThumbnailGenerator *mInstance;
+};
+
+#endif // THUMBNAIL_GENERATOR_H_
@@ -21,6 +21,7 @@
  */
 
 #include "../../app/App.hpp"
+#include "../../utils/Utils.hpp"
 
 #include "ContactModel.hpp"
 
@@ -33,8 +34,7 @@ ContactModel::ContactModel (QObject *parent, shared_ptr<linphone::Friend> linpho
 
   mLinphoneFriend = linphoneFriend;
   mLinphoneFriend->setData("contact-model", *this);
-
-  setVcardModelInternal(new VcardModel(linphoneFriend->getVcard()));
+  mPresenceStatus = static_cast<Presence::PresenceStatus>(mLinphoneFriend->getConsolidatedPresence());
 }
 
 ContactModel::ContactModel (QObject *parent, VcardModel *vcardModel) : QObject(parent) {
@@ -44,6 +44,7 @@ ContactModel::ContactModel (QObject *parent, VcardModel *vcardModel) : QObject(p
 
   mLinphoneFriend = linphone::Friend::newFromVcard(vcardModel->mVcard);
   mLinphoneFriend->setData("contact-model", *this);
+  mPresenceStatus = static_cast<Presence::PresenceStatus>(mLinphoneFriend->getConsolidatedPresence());
 
   qInfo() << QStringLiteral("Create contact from vcard:") << this << vcardModel;
   setVcardModelInternal(vcardModel);
@@ -55,6 +56,10 @@ void ContactModel::refreshPresence () {
   Presence::PresenceStatus status = static_cast<Presence::PresenceStatus>(
       mLinphoneFriend->getConsolidatedPresence()
     );
+  if (status == mPresenceStatus)
+    return;
+
+  mPresenceStatus = status;
 
   emit presenceStatusChanged(status);
   emit presenceLevelChanged(Presence::getPresenceLevel(status));
@@ -62,12 +67,31 @@ void ContactModel::refreshPresence () {
 
 // -----------------------------------------------------------------------------
 
+QString ContactModel::getUsername () const {
+  return ::Utils::coreStringToAppString(mLinphoneFriend->getName());
+}
+
+QString ContactModel::getAvatar () const {
+  return mVcardModel
+    ? mVcardModel->getAvatar()
+    : VcardModel::getAvatarFromVcard(mLinphoneFriend->getVcard());
+}
+
+QStringList ContactModel::getSipAddresses () const {
+  QStringList sipAddresses;
+  for (const auto &address : mLinphoneFriend->getAddresses())
+    sipAddresses << ::Utils::coreStringToAppString(address->asStringUriOnly());
+  return sipAddresses;
+}
+
 VcardModel *ContactModel::getVcardModel () const {
+  if (!mVcardModel)
+    const_cast<ContactModel *>(this)->setVcardModelInternal(new VcardModel(mLinphoneFriend->getVcard()));
   return mVcardModel;
 }
 
 void ContactModel::setVcardModel (VcardModel *vcardModel) {
-  VcardModel *oldVcardModel = mVcardModel;
+  VcardModel *oldVcardModel = getVcardModel();
 
   qInfo() << QStringLiteral("Remove vcard on contact:") << this << oldVcardModel;
   oldVcardModel->mIsReadOnly = false;
@@ -143,16 +167,16 @@ void ContactModel::mergeVcardModel (VcardModel *vcardModel) {
 
   // 1. Merge avatar.
   if (vcardModel->getAvatar().isEmpty())
-    vcardModel->setAvatar(mVcardModel->getAvatar());
+    vcardModel->setAvatar(getVcardModel()->getAvatar());
 
   // 2. Merge sip addresses, companies, emails and urls.
-  for (const auto &sipAddress : mVcardModel->getSipAddresses())
+  for (const auto &sipAddress : getVcardModel()->getSipAddresses())
     vcardModel->addSipAddress(sipAddress.toString());
-  for (const auto &company : mVcardModel->getCompanies())
+  for (const auto &company : getVcardModel()->getCompanies())
     vcardModel->addCompany(company.toString());
-  for (const auto &email : mVcardModel->getEmails())
+  for (const auto &email : getVcardModel()->getEmails())
     vcardModel->addEmail(email.toString());
-  for (const auto &url : mVcardModel->getUrls())
+  for (const auto &url : getVcardModel()->getUrls())
     vcardModel->addUrl(url.toString());
 
   // 3. Merge address.
@@ -181,7 +205,7 @@ void ContactModel::mergeVcardModel (VcardModel *vcardModel) {
 // -----------------------------------------------------------------------------
 
 VcardModel *ContactModel::cloneVcardModel () const {
-  shared_ptr<linphone::Vcard> vcard = mVcardModel->mVcard->clone();
+  shared_ptr<linphone::Vcard> vcard = getVcardModel()->mVcard->clone();
   Q_CHECK_PTR(vcard);
   Q_CHECK_PTR(vcard->getVcard());
 
@@ -198,7 +222,7 @@ VcardModel *ContactModel::cloneVcardModel () const {
 // -----------------------------------------------------------------------------
 
 Presence::PresenceStatus ContactModel::getPresenceStatus () const {
-  return static_cast<Presence::PresenceStatus>(mLinphoneFriend->getConsolidatedPresence());
+  return mPresenceStatus;
 }
 
 Presence::PresenceLevel ContactModel::getPresenceLevel () const {
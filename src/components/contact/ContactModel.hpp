@@ -45,8 +45,15 @@ public:
   ContactModel (QObject *parent, VcardModel *vcardModel);
   ~ContactModel () = default;
 
+  // Signal the presence changes only.
   void refreshPresence ();
 
+  // Read from the linphone friend, the vcard model is not created.
+  QString getUsername () const;
+  QString getAvatar () const;
+  QStringList getSipAddresses () const;
+
+  // Created on first use, most contacts are never displayed.
   VcardModel *getVcardModel () const;
   void setVcardModel (VcardModel *vcardModel);
 
@@ -71,6 +78,9 @@ private:
 
   VcardModel *mVcardModel = nullptr;
   std::shared_ptr<linphone::Friend> mLinphoneFriend;
+
+  // Last signaled presence. A NOTIFY doesn't always change the consolidated presence.
+  Presence::PresenceStatus mPresenceStatus;
 };
 
 Q_DECLARE_METATYPE(ContactModel *);
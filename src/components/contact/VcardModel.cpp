@@ -128,8 +128,12 @@ VcardModel::~VcardModel () {
 // -----------------------------------------------------------------------------
 
 QString VcardModel::getAvatar () const {
+  return getAvatarFromVcard(mVcard);
+}
+
+QString VcardModel::getAvatarFromVcard (const shared_ptr<linphone::Vcard> &vcard) {
   // Find desktop avatar.
-  shared_ptr<belcard::BelCardPhoto> photo = ::findBelcardPhoto(mVcard->getVcard());
+  shared_ptr<belcard::BelCardPhoto> photo = ::findBelcardPhoto(vcard->getVcard());
 
   // No path found.
   if (!photo)
@@ -59,6 +59,9 @@ public:
   QString getAvatar () const;
   bool setAvatar (const QString &path);
 
+  // Read the avatar without vcard model.
+  static QString getAvatarFromVcard (const std::shared_ptr<linphone::Vcard> &vcard);
+
   QString getUsername () const;
   void setUsername (const QString &username);
 
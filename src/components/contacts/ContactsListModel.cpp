@@ -20,7 +20,10 @@
  *      Author: Ronan Abhamon
  */
 
+#include <algorithm>
+
 #include "../../app/App.hpp"
+#include "../../utils/Utils.hpp"
 #include "../core/CoreManager.hpp"
 
 #include "ContactsListModel.hpp"
@@ -97,6 +100,11 @@ bool ContactsListModel::removeRows (int row, int count, const QModelIndex &paren
     ContactModel *contact = mList.takeAt(row);
 
     mLinphoneFriends->removeFriend(contact->mLinphoneFriend);
+    mSearchIndex.remove(contact);
+
+    for (const auto &sipAddress : contact->getSipAddresses())
+      mContactsBySipAddress.remove(sipAddress, contact);
+    mContactsByUsername.remove(mUsernames.take(contact), contact);
 
     emit contactRemoved(contact);
     contact->deleteLater();
@@ -110,19 +118,21 @@ bool ContactsListModel::removeRows (int row, int count, const QModelIndex &paren
 // -----------------------------------------------------------------------------
 
 ContactModel *ContactsListModel::findContactModelFromSipAddress (const QString &sipAddress) const {
-  auto it = find_if(mList.begin(), mList.end(), [&sipAddress](ContactModel *contactModel) {
-        return contactModel->getVcardModel()->getSipAddresses().contains(sipAddress);
-      });
-
-  return it != mList.end() ? *it : nullptr;
+  return findFirstContactModel(mContactsBySipAddress.values(sipAddress));
 }
 
 ContactModel *ContactsListModel::findContactModelFromUsername (const QString &username) const {
-  auto it = find_if(mList.begin(), mList.end(), [&username](ContactModel *contactModel) {
-        return contactModel->getVcardModel()->getUsername() == username;
-      });
+  return findFirstContactModel(mContactsByUsername.values(username));
+}
 
-  return it != mList.end() ? *it : nullptr;
+ContactModel *ContactsListModel::findFirstContactModel (const QList<ContactModel *> &contacts) const {
+  if (contacts.count() <= 1)
+    return contacts.value(0, nullptr);
+
+  // Shared key, returns the first contact of the list like a linear search.
+  return *min_element(contacts.cbegin(), contacts.cend(), [this](ContactModel *a, ContactModel *b) {
+    return mList.indexOf(a) < mList.indexOf(b);
+  });
 }
 
 // -----------------------------------------------------------------------------
@@ -187,14 +197,46 @@ void ContactsListModel::cleanAvatars () {
 
 void ContactsListModel::addContact (ContactModel *contact) {
   QObject::connect(contact, &ContactModel::contactUpdated, this, [this, contact]() {
+      updateUsername(contact);
+      indexContact(contact);
       emit contactUpdated(contact);
     });
   QObject::connect(contact, &ContactModel::sipAddressAdded, this, [this, contact](const QString &sipAddress) {
+      mContactsBySipAddress.insert(sipAddress, contact);
+      indexContact(contact);
       emit sipAddressAdded(contact, sipAddress);
     });
   QObject::connect(contact, &ContactModel::sipAddressRemoved, this, [this, contact](const QString &sipAddress) {
+      mContactsBySipAddress.remove(sipAddress, contact);
+      indexContact(contact);
       emit sipAddressRemoved(contact, sipAddress);
     });
 
   mList << contact;
+
+  for (const auto &sipAddress : contact->getSipAddresses())
+    mContactsBySipAddress.insert(sipAddress, contact);
+  updateUsername(contact);
+  indexContact(contact);
+}
+
+void ContactsListModel::updateUsername (ContactModel *contact) {
+  const QString username = contact->getUsername();
+
+  auto it = mUsernames.find(contact);
+  if (it != mUsernames.end()) {
+    if (*it == username)
+      return;
+    mContactsByUsername.remove(*it, contact);
+  }
+
+  mUsernames[contact] = username;
+  mContactsByUsername.insert(username, contact);
+}
+
+void ContactsListModel::indexContact (const ContactModel *contact) {
+  QStringList strings(contact->getUsername());
+  strings << contact->getSipAddresses();
+
+  mSearchIndex.insert(contact, strings);
 }
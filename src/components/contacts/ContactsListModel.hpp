@@ -26,6 +26,7 @@
 #include <linphone++/linphone.hh>
 #include <QAbstractListModel>
 
+#include "../../utils/SearchIndex.hpp"
 #include "../contact/ContactModel.hpp"
 
 // =============================================================================
@@ -50,6 +51,11 @@ public:
   ContactModel *findContactModelFromSipAddress (const QString &sipAddress) const;
   ContactModel *findContactModelFromUsername (const QString &username) const;
 
+  // Usernames and sip addresses of the contacts.
+  const SearchIndex<const ContactModel *> &getSearchIndex () const {
+    return mSearchIndex;
+  }
+
   Q_INVOKABLE ContactModel *addContact (VcardModel *vcardModel);
   Q_INVOKABLE void removeContact (ContactModel *contact);
 
@@ -65,8 +71,19 @@ signals:
 
 private:
   void addContact (ContactModel *contact);
+  void indexContact (const ContactModel *contact);
+  void updateUsername (ContactModel *contact);
+
+  // The first contact of `mList` among `contacts`.
+  ContactModel *findFirstContactModel (const QList<ContactModel *> &contacts) const;
 
   QList<ContactModel *> mList;
+  SearchIndex<const ContactModel *> mSearchIndex;
+
+  // Lookup tables, updated with the signals of the contacts.
+  QMultiHash<QString, ContactModel *> mContactsBySipAddress;
+  QMultiHash<QString, ContactModel *> mContactsByUsername;
+  QHash<const ContactModel *, QString> mUsernames;
   std::shared_ptr<linphone::FriendList> mLinphoneFriends;
 };
 
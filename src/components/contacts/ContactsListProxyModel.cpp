@@ -54,14 +54,51 @@ const QRegExp ContactsListProxyModel::mSearchSeparators("^[^_.-;@ ][_.-;@ ]");
 // -----------------------------------------------------------------------------
 
 ContactsListProxyModel::ContactsListProxyModel (QObject *parent) : QSortFilterProxyModel(parent) {
-  setSourceModel(CoreManager::getInstance()->getContactsListModel());
+  ContactsListModel *contactsListModel = CoreManager::getInstance()->getContactsListModel();
+
+  // A removed contact address can be reused by a new contact.
+  QObject::connect(contactsListModel, &ContactsListModel::contactRemoved, this, [this](const ContactModel *contact) {
+    mWeights.remove(contact);
+  });
+  QObject::connect(contactsListModel, &ContactsListModel::contactUpdated, this, [this](ContactModel *contact) {
+    mWeights.remove(contact);
+    mRejectedRows.clear();
+    mCandidatesAreDirty = true;
+  });
+  QObject::connect(contactsListModel, &ContactsListModel::sipAddressAdded, this, [this] {
+    mCandidatesAreDirty = true;
+  });
+  QObject::connect(contactsListModel, &ContactsListModel::sipAddressRemoved, this, [this] {
+    mCandidatesAreDirty = true;
+  });
+
+  // Connected before `setSourceModel`, rows are filtered by the proxy after these calls.
+  QObject::connect(contactsListModel, &ContactsListModel::rowsAboutToBeInserted, this, [this] {
+    mRejectedRows.clear();
+    mCandidatesAreDirty = true;
+  });
+  QObject::connect(contactsListModel, &ContactsListModel::rowsAboutToBeRemoved, this, [this] {
+    mRejectedRows.clear();
+  });
+  QObject::connect(contactsListModel, &ContactsListModel::modelAboutToBeReset, this, [this] {
+    mRejectedRows.clear();
+  });
+
+  setSourceModel(contactsListModel);
   sort(0);
 }
 
 // -----------------------------------------------------------------------------
 
 void ContactsListProxyModel::setFilter (const QString &pattern) {
+  // A contact which doesn't contain the old pattern can't contain an extended one.
+  // Otherwise a full pass is necessary.
+  if (!pattern.startsWith(mFilter, Qt::CaseInsensitive))
+    mRejectedRows.clear();
+
   mFilter = pattern;
+  mWeights.clear();
+  mCandidatesAreDirty = true;
   invalidate();
 }
 
@@ -71,12 +108,19 @@ bool ContactsListProxyModel::filterAcceptsRow (
   int sourceRow,
   const QModelIndex &sourceParent
 ) const {
+  if (sourceRow < mRejectedRows.count() && mRejectedRows[sourceRow])
+    return false;
+
   const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
   const ContactModel *contact = index.data().value<ContactModel *>();
 
-  mWeights[contact] = static_cast<unsigned int>(round(computeContactWeight(contact)));
+  // Only the pattern is used to reject rows, the connected filter can change without new pattern.
+  const unsigned int weight = getContactWeight(contact);
+  if (mRejectedRows.count() != sourceModel()->rowCount())
+    mRejectedRows.fill(false, sourceModel()->rowCount());
+  mRejectedRows[sourceRow] = weight == 0;
 
-  return mWeights[contact] > 0 && (
+  return weight > 0 && (
     !mUseConnectedFilter ||
     contact->getPresenceLevel() != Presence::PresenceLevel::White
   );
@@ -86,8 +130,8 @@ bool ContactsListProxyModel::lessThan (const QModelIndex &left, const QModelInde
   const ContactModel *contactA = sourceModel()->data(left).value<ContactModel *>();
   const ContactModel *contactB = sourceModel()->data(right).value<ContactModel *>();
 
-  unsigned int weightA = mWeights[contactA];
-  unsigned int weightB = mWeights[contactB];
+  unsigned int weightA = getContactWeight(contactA);
+  unsigned int weightB = getContactWeight(contactB);
 
   // Sort by weight and name.
   return weightA > weightB || (
@@ -98,6 +142,28 @@ bool ContactsListProxyModel::lessThan (const QModelIndex &left, const QModelInde
 
 // -----------------------------------------------------------------------------
 
+bool ContactsListProxyModel::isCandidate (const ContactModel *contact) const {
+  if (mCandidatesAreDirty) {
+    mUseCandidates = CoreManager::getInstance()->getContactsListModel()->getSearchIndex().find(mFilter, mCandidates);
+    mCandidatesAreDirty = false;
+  }
+
+  return !mUseCandidates || mCandidates.contains(contact);
+}
+
+unsigned int ContactsListProxyModel::getContactWeight (const ContactModel *contact) const {
+  auto it = mWeights.constFind(contact);
+  if (it != mWeights.cend())
+    return *it;
+
+  // The weight can be positive only if the username or an address contains the filter.
+  unsigned int weight = isCandidate(contact)
+    ? static_cast<unsigned int>(round(computeContactWeight(contact)))
+    : 0;
+  mWeights.insert(contact, weight);
+  return weight;
+}
+
 float ContactsListProxyModel::computeStringWeight (const QString &string, float percentage) const {
   int index = -1;
   int offset = -1;
@@ -124,7 +190,7 @@ float ContactsListProxyModel::computeStringWeight (const QString &string, float
 }
 
 float ContactsListProxyModel::computeContactWeight (const ContactModel *contact) const {
-  float weight = computeStringWeight(contact->getVcardModel()->getUsername(), USERNAME_WEIGHT);
+  float weight = computeStringWeight(contact->getUsername(), USERNAME_WEIGHT);
 
   // Get all contact's addresses.
   const list<shared_ptr<linphone::Address> > addresses = contact->mLinphoneFriend->getAddresses();
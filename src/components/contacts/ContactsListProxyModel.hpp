@@ -23,6 +23,7 @@
 #ifndef CONTACTS_LIST_PROXY_MODEL_H_
 #define CONTACTS_LIST_PROXY_MODEL_H_
 
+#include <QSet>
 #include <QSortFilterProxyModel>
 
 // =============================================================================
@@ -50,6 +51,9 @@ protected:
   bool lessThan (const QModelIndex &left, const QModelIndex &right) const override;
 
 private:
+  bool isCandidate (const ContactModel *contact) const;
+  unsigned int getContactWeight (const ContactModel *contact) const;
+
   float computeStringWeight (const QString &string, float percentage) const;
   float computeContactWeight (const ContactModel *contact) const;
 
@@ -62,10 +66,19 @@ private:
   QString mFilter;
   bool mUseConnectedFilter = false;
 
-  // It's just a cache to save values computed by `filterAcceptsRow`
-  // and reused by `lessThan`.
+  // Weights of the contacts for `mFilter`. Computed once per contact,
+  // kept when only the connected filter changes.
   mutable QHash<const ContactModel *, unsigned int> mWeights;
 
+  // Contacts which contain `mFilter`, given by the search index of the source model.
+  // Not used if the filter is too short.
+  mutable QSet<const ContactModel *> mCandidates;
+  mutable bool mUseCandidates = false;
+  mutable bool mCandidatesAreDirty = true;
+
+  // Source rows without match for the current pattern. Skipped when the pattern is extended.
+  mutable QVector<bool> mRejectedRows;
+
   static const QRegExp mSearchSeparators;
 };
 
@@ -20,6 +20,8 @@
  *      Author: Ronan Abhamon
  */
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QDir>
 #include <QtConcurrent>
@@ -27,12 +29,20 @@
 
 #include "../../app/paths/Paths.hpp"
 #include "../../utils/Utils.hpp"
+#include "../chat/FileTransferScheduler.hpp"
+#include "../chat/ThumbnailGenerator.hpp"
 #include "MessagesCountNotifier.hpp"
 
 #include "CoreManager.hpp"
 
 #define CBS_CALL_INTERVAL 20
 
+// Recently used chat models kept alive to switch instantly between rooms.
+#define MAX_CACHED_CHAT_MODELS 10
+
+// Max number of entries of the cached chat models, the most recent model is always kept.
+#define MAX_CACHED_CHAT_ENTRIES 5000
+
 #define DOWNLOAD_URL "https://www.linphone.org/technical-corner/linphone/downloads"
 
 using namespace std;
@@ -62,7 +72,14 @@ CoreManager::CoreManager (QObject *parent, const QString &configPath) :
     mInstance->mSipAddressesModel = new SipAddressesModel(mInstance);
     mInstance->mSettingsModel = new SettingsModel(mInstance);
     mInstance->mAccountSettingsModel = new AccountSettingsModel(mInstance);
+    mInstance->mChatSearchIndex = new ChatSearchIndex(mInstance);
 
+    // Received files are downloaded even if no chat room is displayed.
+    FileTransferScheduler::getInstance();
+
+    ThumbnailGenerator::getInstance()->scheduleSweep();
+
+    mInstance->mIsStarted = true;
     emit mInstance->coreStarted();
   });
 
@@ -82,26 +99,111 @@ shared_ptr<ChatModel> CoreManager::getChatModelFromSipAddress (const QString &si
 
   // Create a new chat model.
   if (!mChatModels.contains(sipAddress)) {
-    Q_ASSERT(mCore->createAddress(::Utils::appStringToCoreString(sipAddress)) != nullptr);
-
-    auto deleter = [this](ChatModel *chatModel) {
-        mChatModels.remove(chatModel->getSipAddress());
-      };
-
-    shared_ptr<ChatModel> chatModel(new ChatModel(sipAddress), deleter);
-    mChatModels[sipAddress] = chatModel;
-
-    emit chatModelCreated(chatModel);
-
+    shared_ptr<ChatModel> chatModel = createChatModel(sipAddress);
+    cacheChatModel(chatModel);
     return chatModel;
   }
 
   // Returns an existing chat model.
   shared_ptr<ChatModel> chatModel = mChatModels[sipAddress].lock();
   Q_CHECK_PTR(chatModel.get());
+  cacheChatModel(chatModel);
   return chatModel;
 }
 
+shared_ptr<ChatModel> CoreManager::createChatModel (const QString &sipAddress) {
+  Q_ASSERT(mCore->createAddress(::Utils::appStringToCoreString(sipAddress)) != nullptr);
+
+  // The last reference can be released in a slot of the chat model.
+  auto deleter = [this](ChatModel *chatModel) {
+      mChatModels.remove(chatModel->getSipAddress());
+      chatModel->deleteLater();
+    };
+
+  shared_ptr<ChatModel> chatModel(new ChatModel(sipAddress), deleter);
+  mChatModels[sipAddress] = chatModel;
+
+  emit chatModelCreated(chatModel);
+
+  return chatModel;
+}
+
+void CoreManager::cacheChatModel (const shared_ptr<ChatModel> &chatModel) {
+  auto it = find(mChatModelsCache.begin(), mChatModelsCache.end(), chatModel);
+  if (it != mChatModelsCache.end())
+    mChatModelsCache.splice(mChatModelsCache.begin(), mChatModelsCache, it);
+  else
+    mChatModelsCache.push_front(chatModel);
+
+  // Evict the least recently used models. Entry counts can grow after the insertion,
+  // so the budget is checked at each access.
+  int entriesCount = 0;
+  int modelsCount = 0;
+  for (it = mChatModelsCache.begin(); it != mChatModelsCache.end(); ++it) {
+    entriesCount += (*it)->rowCount();
+    if (++modelsCount > 1 && (modelsCount > MAX_CACHED_CHAT_MODELS || entriesCount > MAX_CACHED_CHAT_ENTRIES))
+      break;
+  }
+
+  mChatModelsCache.erase(it, mChatModelsCache.end());
+}
+
+bool CoreManager::chatModelsCacheCanHold (int entriesCount) const {
+  if (mChatModelsCache.size() >= MAX_CACHED_CHAT_MODELS)
+    return false;
+
+  for (const auto &chatModel : mChatModelsCache)
+    entriesCount += chatModel->rowCount();
+  return entriesCount <= MAX_CACHED_CHAT_ENTRIES;
+}
+
+// -----------------------------------------------------------------------------
+
+void CoreManager::prefetchChatModel (const QString &sipAddress) {
+  if (sipAddress.isEmpty() || mChatModels.contains(sipAddress) || mChatModelsToPrefetch.contains(sipAddress))
+    return;
+
+  mChatModelsToPrefetch << sipAddress;
+
+  if (!mPrefetchTimer) {
+    mPrefetchTimer = new QTimer(this);
+    mPrefetchTimer->setInterval(0);
+    QObject::connect(mPrefetchTimer, &QTimer::timeout, this, &CoreManager::prefetchNextChatModel);
+  }
+  mPrefetchTimer->start();
+}
+
+void CoreManager::cancelChatModelPrefetch (const QString &sipAddress) {
+  mChatModelsToPrefetch.removeOne(sipAddress);
+}
+
+void CoreManager::prefetchNextChatModel () {
+  // A prefetch never evicts a used model.
+  if (mChatModelsToPrefetch.isEmpty() || !chatModelsCacheCanHold(1)) {
+    mChatModelsToPrefetch.clear();
+    mPrefetchTimer->stop();
+    return;
+  }
+
+  const QString sipAddress = mChatModelsToPrefetch.takeFirst();
+  if (mChatModels.contains(sipAddress))
+    return;
+
+  // The entries count is known only once the first page is loaded.
+  shared_ptr<ChatModel> chatModel = createChatModel(sipAddress);
+  if (!chatModelsCacheCanHold(chatModel->rowCount())) {
+    qInfo() << QStringLiteral("Skip chat model prefetch: `%1` (cache is full).").arg(sipAddress);
+    mChatModelsToPrefetch.clear();
+    mPrefetchTimer->stop();
+    return;
+  }
+
+  qInfo() << QStringLiteral("Prefetch chat model: `%1`.").arg(sipAddress);
+
+  // Cached as the least recently used model, without eviction.
+  mChatModelsCache.push_back(chatModel);
+}
+
 // -----------------------------------------------------------------------------
 
 void CoreManager::init (QObject *parent, const QString &configPath) {
@@ -27,6 +27,7 @@
 
 #include "../calls/CallsListModel.hpp"
 #include "../chat/ChatModel.hpp"
+#include "../chat/ChatSearchIndex.hpp"
 #include "../contacts/ContactsListModel.hpp"
 #include "../settings/AccountSettingsModel.hpp"
 #include "../settings/SettingsModel.hpp"
@@ -59,6 +60,10 @@ public:
 
   std::shared_ptr<ChatModel> getChatModelFromSipAddress (const QString &sipAddress);
 
+  // Create chat models in advance, one per event loop iteration, while the cache has room.
+  void prefetchChatModel (const QString &sipAddress);
+  void cancelChatModelPrefetch (const QString &sipAddress);
+
   // ---------------------------------------------------------------------------
   // Video render lock.
   // ---------------------------------------------------------------------------
@@ -100,6 +105,11 @@ public:
     return mAccountSettingsModel;
   }
 
+  ChatSearchIndex *getChatSearchIndex () const {
+    Q_CHECK_PTR(mChatSearchIndex);
+    return mChatSearchIndex;
+  }
+
   // ---------------------------------------------------------------------------
   // Initialization.
   // ---------------------------------------------------------------------------
@@ -112,6 +122,11 @@ public:
     return mInstance;
   }
 
+  // True if the core is started and the singleton models are created.
+  bool isStarted () const {
+    return mIsStarted;
+  }
+
   // ---------------------------------------------------------------------------
 
   // Must be used in a qml scene.
@@ -142,6 +157,15 @@ private:
 
   QString getVersion () const;
 
+  std::shared_ptr<ChatModel> createChatModel (const QString &sipAddress);
+
+  void cacheChatModel (const std::shared_ptr<ChatModel> &chatModel);
+
+  // True if a model of `entriesCount` entries can be added without eviction.
+  bool chatModelsCacheCanHold (int entriesCount) const;
+
+  void prefetchNextChatModel ();
+
   void iterate ();
 
   void handleLogsUploadStateChanged (linphone::CoreLogCollectionUploadState state, const std::string &info);
@@ -156,9 +180,18 @@ private:
   SipAddressesModel *mSipAddressesModel = nullptr;
   SettingsModel *mSettingsModel = nullptr;
   AccountSettingsModel *mAccountSettingsModel = nullptr;
+  ChatSearchIndex *mChatSearchIndex = nullptr;
+
+  bool mIsStarted = false;
 
   QHash<QString, std::weak_ptr<ChatModel> > mChatModels;
 
+  // Recently used chat models. (Most recent first.)
+  std::list<std::shared_ptr<ChatModel> > mChatModelsCache;
+
+  QStringList mChatModelsToPrefetch;
+  QTimer *mPrefetchTimer = nullptr;
+
   QTimer *mCbsTimer = nullptr;
 
   QFuture<void> mPromiseBuild;
@@ -276,6 +276,35 @@ void SettingsModel::setFileTransferUrl (const QString &url) {
 
 // -----------------------------------------------------------------------------
 
+int SettingsModel::getMaxFileDownloads () const {
+  return qMax(mConfig->getInt(UI_SECTION, "max_file_downloads", 3), 1);
+}
+
+void SettingsModel::setMaxFileDownloads (int count) {
+  mConfig->setInt(UI_SECTION, "max_file_downloads", count);
+  emit maxFileDownloadsChanged(count);
+}
+
+int SettingsModel::getFileTransferBandwidth () const {
+  return mConfig->getInt(UI_SECTION, "file_transfer_bandwidth", 0);
+}
+
+void SettingsModel::setFileTransferBandwidth (int bandwidth) {
+  mConfig->setInt(UI_SECTION, "file_transfer_bandwidth", bandwidth);
+  emit fileTransferBandwidthChanged(bandwidth);
+}
+
+int SettingsModel::getAutoDownloadSizeLimit () const {
+  return mConfig->getInt(UI_SECTION, "auto_download_size_limit", 0);
+}
+
+void SettingsModel::setAutoDownloadSizeLimit (int size) {
+  mConfig->setInt(UI_SECTION, "auto_download_size_limit", size);
+  emit autoDownloadSizeLimitChanged(size);
+}
+
+// -----------------------------------------------------------------------------
+
 bool SettingsModel::getLimeIsSupported () const {
   return CoreManager::getInstance()->getCore()->limeAvailable();
 }
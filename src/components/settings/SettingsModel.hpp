@@ -68,6 +68,10 @@ class SettingsModel : public QObject {
 
   Q_PROPERTY(QString fileTransferUrl READ getFileTransferUrl WRITE setFileTransferUrl NOTIFY fileTransferUrlChanged);
 
+  Q_PROPERTY(int maxFileDownloads READ getMaxFileDownloads WRITE setMaxFileDownloads NOTIFY maxFileDownloadsChanged);
+  Q_PROPERTY(int fileTransferBandwidth READ getFileTransferBandwidth WRITE setFileTransferBandwidth NOTIFY fileTransferBandwidthChanged);
+  Q_PROPERTY(int autoDownloadSizeLimit READ getAutoDownloadSizeLimit WRITE setAutoDownloadSizeLimit NOTIFY autoDownloadSizeLimitChanged);
+
   Q_PROPERTY(bool limeIsSupported READ getLimeIsSupported CONSTANT);
   Q_PROPERTY(QVariantList supportedMediaEncryptions READ getSupportedMediaEncryptions CONSTANT);
 
@@ -200,6 +204,17 @@ public:
   QString getFileTransferUrl () const;
   void setFileTransferUrl (const QString &url);
 
+  int getMaxFileDownloads () const;
+  void setMaxFileDownloads (int count);
+
+  // In KiB/s, 0 if unlimited.
+  int getFileTransferBandwidth () const;
+  void setFileTransferBandwidth (int bandwidth);
+
+  // In bytes, 0 if disabled.
+  int getAutoDownloadSizeLimit () const;
+  void setAutoDownloadSizeLimit (int size);
+
   bool getLimeIsSupported () const;
   QVariantList getSupportedMediaEncryptions () const;
 
@@ -337,6 +352,10 @@ signals:
 
   void fileTransferUrlChanged (const QString &url);
 
+  void maxFileDownloadsChanged (int count);
+  void fileTransferBandwidthChanged (int bandwidth);
+  void autoDownloadSizeLimitChanged (int size);
+
   void mediaEncryptionChanged (MediaEncryption encryption);
   void limeStateChanged (LimeState state);
 
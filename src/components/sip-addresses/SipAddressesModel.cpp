@@ -20,19 +20,50 @@
  *      Author: Ronan Abhamon
  */
 
+#include <algorithm>
+
+#include <QDataStream>
 #include <QDateTime>
+#include <QSaveFile>
+#include <QTimer>
 
+#include "../../app/paths/Paths.hpp"
 #include "../../utils/LinphoneUtils.hpp"
 #include "../../utils/Utils.hpp"
 #include "../core/CoreManager.hpp"
 
 #include "SipAddressesModel.hpp"
 
+// Delay between a change of the timeline summary and its save. (In ms.)
+#define TIMELINE_SUMMARY_SAVE_DELAY 5000
+
+#define TIMELINE_SUMMARY_MAGIC 0x4C54534D
+#define TIMELINE_SUMMARY_VERSION 1
+
 using namespace std;
 
 // =============================================================================
 
+inline qint64 getCallLogTime (const shared_ptr<linphone::CallLog> &callLog) {
+  // The duration can be wrong if status is not success.
+  return callLog->getStatus() == linphone::CallStatus::CallStatusSuccess
+    ? callLog->getStartDate() + callLog->getDuration()
+    : callLog->getStartDate();
+}
+
+// -----------------------------------------------------------------------------
+
 SipAddressesModel::SipAddressesModel (QObject *parent) : QAbstractListModel(parent) {
+  mTimelineSummarySaveTimer = new QTimer(this);
+  mTimelineSummarySaveTimer->setSingleShot(true);
+  mTimelineSummarySaveTimer->setInterval(TIMELINE_SUMMARY_SAVE_DELAY);
+  QObject::connect(mTimelineSummarySaveTimer, &QTimer::timeout, this, &SipAddressesModel::saveTimelineSummary);
+
+  mPresenceTimer = new QTimer(this);
+  mPresenceTimer->setSingleShot(true);
+  mPresenceTimer->setInterval(0);
+  QObject::connect(mPresenceTimer, &QTimer::timeout, this, &SipAddressesModel::signalPresenceChanges);
+
   initSipAddresses();
 
   CoreManager *coreManager = CoreManager::getInstance();
@@ -44,6 +75,7 @@ SipAddressesModel::SipAddressesModel (QObject *parent) : QAbstractListModel(pare
   ContactsListModel *contacts = CoreManager::getInstance()->getContactsListModel();
   QObject::connect(contacts, &ContactsListModel::contactAdded, this, &SipAddressesModel::handleContactAdded);
   QObject::connect(contacts, &ContactsListModel::contactRemoved, this, &SipAddressesModel::handleContactRemoved);
+  QObject::connect(contacts, &ContactsListModel::contactUpdated, this, &SipAddressesModel::handleContactUpdated);
   QObject::connect(contacts, &ContactsListModel::sipAddressAdded, this, &SipAddressesModel::handleSipAddressAdded);
   QObject::connect(contacts, &ContactsListModel::sipAddressRemoved, this, &SipAddressesModel::handleSipAddressRemoved);
 
@@ -54,6 +86,11 @@ SipAddressesModel::SipAddressesModel (QObject *parent) : QAbstractListModel(pare
   QObject::connect(coreHandlers, &CoreHandlers::isComposingChanged, this, &SipAddressesModel::handlerIsComposingChanged);
 }
 
+SipAddressesModel::~SipAddressesModel () {
+  if (mTimelineSummarySaveTimer->isActive())
+    saveTimelineSummary();
+}
+
 // -----------------------------------------------------------------------------
 
 int SipAddressesModel::rowCount (const QModelIndex &) const {
@@ -72,8 +109,16 @@ QVariant SipAddressesModel::data (const QModelIndex &index, int role) const {
   if (!index.isValid() || row < 0 || row >= mRefs.count())
     return QVariant();
 
-  if (role == Qt::DisplayRole)
-    return QVariant::fromValue(*mRefs[row]);
+  switch (role) {
+    case Roles::Entry:
+      return QVariant::fromValue(*mRefs[row]);
+    case Roles::SipAddress:
+      return mRefs[row]->value("sipAddress");
+    case Roles::Contact:
+      return mRefs[row]->value("contact");
+    case Roles::Timestamp:
+      return mRefs[row]->value("timestamp");
+  }
 
   return QVariant();
 }
@@ -200,9 +245,15 @@ bool SipAddressesModel::removeRows (int row, int count, const QModelIndex &paren
     QString sipAddress = (*map)["sipAddress"].toString();
 
     qInfo() << QStringLiteral("Remove sip address: `%1`.").arg(sipAddress);
+    mRowIndex.remove(map);
+    mSearchIndex.remove(sipAddress);
     mSipAddresses.remove(sipAddress);
   }
 
+  // Removals are rare, only the following rows are updated.
+  for (int i = row; i < mRefs.count(); ++i)
+    mRowIndex[mRefs[i]] = i;
+
   endRemoveRows();
 
   return true;
@@ -218,6 +269,10 @@ void SipAddressesModel::handleChatModelCreated (const shared_ptr<ChatModel> &cha
   });
 
   QObject::connect(ptr, &ChatModel::messageSent, this, &SipAddressesModel::handleMessageSent);
+  QObject::connect(ptr, &ChatModel::messageRemoved, this, &SipAddressesModel::handleMessageRemoved);
+  QObject::connect(ptr, &ChatModel::callLogsRemoved, this, [this, ptr](const list<shared_ptr<linphone::CallLog> > &callLogs) {
+    handleCallLogsRemoved(ptr->getSipAddress(), callLogs);
+  });
 
   QObject::connect(ptr, &ChatModel::messagesCountReset, this, [this, ptr] {
     handleMessagesCountReset(ptr->getSipAddress());
@@ -225,13 +280,28 @@ void SipAddressesModel::handleChatModelCreated (const shared_ptr<ChatModel> &cha
 }
 
 void SipAddressesModel::handleContactAdded (ContactModel *contact) {
-  for (const auto &sipAddress : contact->getVcardModel()->getSipAddresses())
-    addOrUpdateSipAddress(sipAddress.toString(), contact);
+  for (const auto &sipAddress : contact->getSipAddresses())
+    addOrUpdateSipAddress(sipAddress, contact);
 }
 
 void SipAddressesModel::handleContactRemoved (const ContactModel *contact) {
-  for (const auto &sipAddress : contact->getVcardModel()->getSipAddresses())
-    removeContactOfSipAddress(sipAddress.toString());
+  for (const auto &sipAddress : contact->getSipAddresses())
+    removeContactOfSipAddress(sipAddress);
+}
+
+void SipAddressesModel::handleContactUpdated (ContactModel *contact) {
+  // The username can be changed.
+  for (const auto &sipAddress : contact->getSipAddresses()) {
+    auto it = mSipAddresses.find(sipAddress);
+    if (it == mSipAddresses.end() || it->value("contact").value<ContactModel *>() != contact)
+      continue;
+
+    indexSipAddress(*it);
+
+    int row = mRowIndex.value(&(*it), -1);
+    Q_ASSERT(row != -1);
+    emit dataChanged(index(row, 0), index(row, 0));
+  }
 }
 
 void SipAddressesModel::handleSipAddressAdded (ContactModel *contact, const QString &sipAddress) {
@@ -294,17 +364,54 @@ void SipAddressesModel::handlePresenceReceived (
       break;
   }
 
-  auto it = mSipAddresses.find(sipAddress);
-  if (it != mSipAddresses.end()) {
-    qInfo() << QStringLiteral("Update presence of `%1`: %2.").arg(sipAddress).arg(status);
-    (*it)["presenceStatus"] = status;
+  // Drop the no-op updates. Addresses without entry can have observers.
+  auto it = mSipAddresses.constFind(sipAddress);
+  if (
+    it != mSipAddresses.cend() &&
+    it->value("presenceStatus", Presence::PresenceStatus::Offline).value<Presence::PresenceStatus>() == status &&
+    !mPendingPresences.contains(sipAddress)
+  )
+    return;
 
-    int row = mRefs.indexOf(&(*it));
-    Q_ASSERT(row != -1);
-    emit dataChanged(index(row, 0), index(row, 0));
+  // Changes are signaled once per event loop iteration. (A NOTIFY can contain many friends.)
+  mPendingPresences[sipAddress] = status;
+  if (!mPresenceTimer->isActive())
+    mPresenceTimer->start();
+}
+
+void SipAddressesModel::signalPresenceChanges () {
+  QVector<int> rows;
+  rows.reserve(mPendingPresences.count());
+
+  for (auto it = mPendingPresences.cbegin(); it != mPendingPresences.cend(); ++it) {
+    const QString &sipAddress = it.key();
+    const Presence::PresenceStatus status = it.value();
+
+    auto mapIt = mSipAddresses.find(sipAddress);
+    if (mapIt != mSipAddresses.end()) {
+      (*mapIt)["presenceStatus"] = status;
+
+      int row = mRowIndex.value(&(*mapIt), -1);
+      Q_ASSERT(row != -1);
+      rows << row;
+    }
+
+    updateObservers(sipAddress, status);
   }
 
-  updateObservers(sipAddress, status);
+  qInfo() << QStringLiteral("Update presence of %1 sip address(es).").arg(mPendingPresences.count());
+  mPendingPresences.clear();
+
+  // Emit one signal per range of consecutive rows.
+  std::sort(rows.begin(), rows.end());
+  for (int i = 0, count = rows.count(); i < count; ++i) {
+    int first = rows[i];
+    int last = first;
+    while (i + 1 < count && rows[i + 1] == last + 1)
+      last = rows[++i];
+
+    emit dataChanged(index(first, 0), index(last, 0));
+  }
 }
 
 void SipAddressesModel::handleAllEntriesRemoved (const QString &sipAddress) {
@@ -314,18 +421,60 @@ void SipAddressesModel::handleAllEntriesRemoved (const QString &sipAddress) {
     return;
   }
 
-  int row = mRefs.indexOf(&(*it));
+  int row = mRowIndex.value(&(*it), -1);
   Q_ASSERT(row != -1);
 
   // No history, no contact => Remove sip address from list.
   if (!it->contains("contact")) {
     removeRow(row);
+    removeTimelineSummary(sipAddress);
     return;
   }
 
   // Signal changes.
   it->remove("timestamp");
   emit dataChanged(index(row, 0), index(row, 0));
+
+  removeTimelineSummary(sipAddress);
+}
+
+void SipAddressesModel::handleMessageRemoved (const shared_ptr<linphone::ChatMessage> &message) {
+  shared_ptr<linphone::ChatRoom> chatRoom = message->getChatRoom();
+  const QString sipAddress = ::Utils::coreStringToAppString(chatRoom->getPeerAddress()->asStringUriOnly());
+
+  auto it = mTimelineSummary.find(sipAddress);
+  if (it == mTimelineSummary.end() || message->getTime() < it->lastMessageTime)
+    return;
+
+  // The message is already removed from the history.
+  list<shared_ptr<linphone::ChatMessage> > history = chatRoom->getHistoryRange(0, 0);
+  it->lastMessageTime = history.empty() ? 0 : history.back()->getTime();
+
+  signalTimelineSummaryDecrease(sipAddress);
+}
+
+void SipAddressesModel::handleCallLogsRemoved (const QString &sipAddress, const list<shared_ptr<linphone::CallLog> > &callLogs) {
+  auto it = mTimelineSummary.find(sipAddress);
+  if (it == mTimelineSummary.end())
+    return;
+
+  if (none_of(callLogs.cbegin(), callLogs.cend(), [&it](const shared_ptr<linphone::CallLog> &callLog) {
+    return ::getCallLogTime(callLog) >= it->lastCallTime;
+  }))
+    return;
+
+  // The call logs are removed later from the core, skip them.
+  qint64 lastCallTime = 0;
+  shared_ptr<linphone::Core> core = CoreManager::getInstance()->getCore();
+  for (const auto &callLog : core->getCallHistoryForAddress(callLogs.front()->getRemoteAddress()))
+    if (
+      callLog->getStatus() != linphone::CallStatusAborted &&
+      find(callLogs.cbegin(), callLogs.cend(), callLog) == callLogs.cend()
+    )
+      lastCallTime = qMax(lastCallTime, ::getCallLogTime(callLog));
+  it->lastCallTime = lastCallTime;
+
+  signalTimelineSummaryDecrease(sipAddress);
 }
 
 void SipAddressesModel::handleMessageSent (const shared_ptr<linphone::ChatMessage> &message) {
@@ -340,7 +489,7 @@ void SipAddressesModel::handleMessagesCountReset (const QString &sipAddress) {
   if (it != mSipAddresses.end()) {
     (*it)["unreadMessagesCount"] = 0;
 
-    int row = mRefs.indexOf(&(*it));
+    int row = mRowIndex.value(&(*it), -1);
     Q_ASSERT(row != -1);
     emit dataChanged(index(row, 0), index(row, 0));
   }
@@ -353,7 +502,7 @@ void SipAddressesModel::handlerIsComposingChanged (const shared_ptr<linphone::Ch
   if (it != mSipAddresses.end()) {
     (*it)["isComposing"] = chatRoom->isRemoteComposing();
 
-    int row = mRefs.indexOf(&(*it));
+    int row = mRowIndex.value(&(*it), -1);
     Q_ASSERT(row != -1);
     emit dataChanged(index(row, 0), index(row, 0));
   }
@@ -369,15 +518,16 @@ void SipAddressesModel::addOrUpdateSipAddress (QVariantMap &map, ContactModel *c
   else if (map.remove("contact") == 0)
     qWarning() << QStringLiteral("`contact` field is empty on sip address: `%1`.").arg(sipAddress);
 
+  indexSipAddress(map);
+
   updateObservers(sipAddress, contact);
 }
 
 void SipAddressesModel::addOrUpdateSipAddress (QVariantMap &map, const shared_ptr<linphone::Call> &call) {
-  const shared_ptr<linphone::CallLog> callLog = call->getCallLog();
+  const qint64 time = ::getCallLogTime(call->getCallLog());
 
-  map["timestamp"] = callLog->getStatus() == linphone::CallStatus::CallStatusSuccess
-    ? QDateTime::fromMSecsSinceEpoch((callLog->getStartDate() + callLog->getDuration()) * 1000)
-    : QDateTime::fromMSecsSinceEpoch(callLog->getStartDate() * 1000);
+  map["timestamp"] = QDateTime::fromMSecsSinceEpoch(time * 1000);
+  updateTimelineSummary(map["sipAddress"].toString(), 0, time);
 }
 
 void SipAddressesModel::addOrUpdateSipAddress (QVariantMap &map, const shared_ptr<linphone::ChatMessage> &message) {
@@ -385,6 +535,7 @@ void SipAddressesModel::addOrUpdateSipAddress (QVariantMap &map, const shared_pt
 
   map["timestamp"] = QDateTime::fromMSecsSinceEpoch(message->getTime() * 1000);
   map["unreadMessagesCount"] = count;
+  updateTimelineSummary(map["sipAddress"].toString(), message->getTime(), 0);
 
   updateObservers(map["sipAddress"].toString(), count);
 }
@@ -395,7 +546,7 @@ void SipAddressesModel::addOrUpdateSipAddress (const QString &sipAddress, T data
   if (it != mSipAddresses.end()) {
     addOrUpdateSipAddress(*it, data);
 
-    int row = mRefs.indexOf(&(*it));
+    int row = mRowIndex.value(&(*it), -1);
     Q_ASSERT(row != -1);
     emit dataChanged(index(row, 0), index(row, 0));
 
@@ -406,6 +557,10 @@ void SipAddressesModel::addOrUpdateSipAddress (const QString &sipAddress, T data
   map["sipAddress"] = sipAddress;
   addOrUpdateSipAddress(map, data);
 
+  // Already indexed by the contact overload.
+  if (!map.contains("contact"))
+    indexSipAddress(map);
+
   int row = mRefs.count();
 
   beginInsertRows(QModelIndex(), row, row);
@@ -414,6 +569,7 @@ void SipAddressesModel::addOrUpdateSipAddress (const QString &sipAddress, T data
 
   mSipAddresses[sipAddress] = map;
   mRefs << &mSipAddresses[sipAddress];
+  mRowIndex[mRefs.last()] = row;
 
   endInsertRows();
 }
@@ -434,7 +590,7 @@ void SipAddressesModel::removeContactOfSipAddress (const QString &sipAddress) {
   qInfo() << QStringLiteral("Map new contact on sip address: `%1`.").arg(sipAddress) << contactModel;
   addOrUpdateSipAddress(*it, contactModel);
 
-  int row = mRefs.indexOf(&(*it));
+  int row = mRowIndex.value(&(*it), -1);
   Q_ASSERT(row != -1);
 
   // History exists, signal changes.
@@ -447,55 +603,87 @@ void SipAddressesModel::removeContactOfSipAddress (const QString &sipAddress) {
   removeRow(row);
 }
 
+void SipAddressesModel::indexSipAddress (const QVariantMap &map) {
+  const QString sipAddress = map["sipAddress"].toString();
+
+  // Same strings as the weights of `SipAddressesProxyModel`.
+  QStringList strings(sipAddress.mid(4));
+  const ContactModel *contact = map.value("contact").value<ContactModel *>();
+  if (contact)
+    strings << contact->getUsername();
+
+  mSearchIndex.insert(sipAddress, strings);
+}
+
 void SipAddressesModel::initSipAddresses () {
   shared_ptr<linphone::Core> core = CoreManager::getInstance()->getCore();
 
-  // Get sip addresses from chatrooms.
-  for (const auto &chatRoom : core->getChatRooms()) {
-    list<shared_ptr<linphone::ChatMessage> > history = chatRoom->getHistory(0);
-
-    if (history.size() == 0)
-      continue;
+  const bool summaryLoaded = loadTimelineSummary();
+  bool summaryChanged = !summaryLoaded;
 
+  // Get sip addresses from chatrooms. Only the newest message of unknown rooms is read.
+  QHash<QString, int> unreadMessagesCounts;
+  for (const auto &chatRoom : core->getChatRooms()) {
     QString sipAddress = ::Utils::coreStringToAppString(chatRoom->getPeerAddress()->asStringUriOnly());
+    unreadMessagesCounts[sipAddress] = chatRoom->getUnreadMessagesCount();
 
-    QVariantMap map;
-    map["sipAddress"] = sipAddress;
-    map["timestamp"] = QDateTime::fromMSecsSinceEpoch(history.back()->getTime() * 1000);
-    map["unreadMessagesCount"] = chatRoom->getUnreadMessagesCount();
+    TimelineSummary &summary = mTimelineSummary[sipAddress];
+    if (summary.lastMessageTime != 0)
+      continue;
 
-    mSipAddresses[sipAddress] = map;
+    list<shared_ptr<linphone::ChatMessage> > history = chatRoom->getHistoryRange(0, 0);
+    if (!history.empty()) {
+      summary.lastMessageTime = history.back()->getTime();
+      summaryChanged = true;
+    }
   }
 
-  // Get sip addresses from calls.
-  QSet<QString> addressDone;
-  for (const auto &callLog : core->getCallLogs()) {
-    const QString sipAddress = ::Utils::coreStringToAppString(callLog->getRemoteAddress()->asStringUriOnly());
+  // Get sip addresses from calls. Without summary only.
+  if (!summaryLoaded)
+    for (const auto &callLog : core->getCallLogs()) {
+      if (callLog->getStatus() == linphone::CallStatusAborted)
+        continue; // Ignore aborted calls.
 
-    if (addressDone.contains(sipAddress))
-      continue; // Already used.
+      TimelineSummary &summary = mTimelineSummary[
+        ::Utils::coreStringToAppString(callLog->getRemoteAddress()->asStringUriOnly())
+      ];
+      summary.lastCallTime = qMax(summary.lastCallTime, ::getCallLogTime(callLog));
+    }
 
-    if (callLog->getStatus() == linphone::CallStatusAborted)
-      continue; // Ignore aborted calls.
+  for (auto it = mTimelineSummary.begin(); it != mTimelineSummary.end(); ) {
+    const QString &sipAddress = it.key();
 
-    addressDone << sipAddress;
+    // Room removed since the last save.
+    auto unreadIt = unreadMessagesCounts.constFind(sipAddress);
+    if (unreadIt == unreadMessagesCounts.cend() && it->lastMessageTime != 0) {
+      it->lastMessageTime = 0;
+      summaryChanged = true;
+    }
+
+    const qint64 time = qMax(it->lastMessageTime, it->lastCallTime);
+    if (time == 0) {
+      it = mTimelineSummary.erase(it);
+      continue;
+    }
 
     QVariantMap map;
     map["sipAddress"] = sipAddress;
+    map["timestamp"] = QDateTime::fromMSecsSinceEpoch(time * 1000);
+    if (unreadIt != unreadMessagesCounts.cend())
+      map["unreadMessagesCount"] = *unreadIt;
 
-    // The duration can be wrong if status is not success.
-    map["timestamp"] = callLog->getStatus() == linphone::CallStatus::CallStatusSuccess
-      ? QDateTime::fromMSecsSinceEpoch((callLog->getStartDate() + callLog->getDuration()) * 1000)
-      : QDateTime::fromMSecsSinceEpoch(callLog->getStartDate() * 1000);
-
-    auto it = mSipAddresses.find(sipAddress);
-    if (it == mSipAddresses.end() || map["timestamp"] > (*it)["timestamp"])
-      mSipAddresses[sipAddress] = map;
+    mSipAddresses[sipAddress] = map;
+    ++it;
   }
 
+  if (summaryChanged)
+    mTimelineSummarySaveTimer->start();
+
   for (const auto &map : mSipAddresses) {
     qInfo() << QStringLiteral("Add sip address: `%1`.").arg(map["sipAddress"].toString());
+    mRowIndex[&map] = mRefs.count();
     mRefs << &map;
+    indexSipAddress(map);
   }
 
   // Get sip addresses from contacts.
@@ -505,6 +693,97 @@ void SipAddressesModel::initSipAddresses () {
 
 // -----------------------------------------------------------------------------
 
+void SipAddressesModel::updateTimelineSummary (const QString &sipAddress, qint64 lastMessageTime, qint64 lastCallTime) {
+  TimelineSummary &summary = mTimelineSummary[sipAddress];
+  summary.lastMessageTime = qMax(summary.lastMessageTime, lastMessageTime);
+  summary.lastCallTime = qMax(summary.lastCallTime, lastCallTime);
+
+  if (!mTimelineSummarySaveTimer->isActive())
+    mTimelineSummarySaveTimer->start();
+}
+
+void SipAddressesModel::removeTimelineSummary (const QString &sipAddress) {
+  if (mTimelineSummary.remove(sipAddress) && !mTimelineSummarySaveTimer->isActive())
+    mTimelineSummarySaveTimer->start();
+}
+
+void SipAddressesModel::signalTimelineSummaryDecrease (const QString &sipAddress) {
+  if (!mTimelineSummarySaveTimer->isActive())
+    mTimelineSummarySaveTimer->start();
+
+  // Without activity, the sip address is updated by `handleAllEntriesRemoved`.
+  const TimelineSummary summary = mTimelineSummary.value(sipAddress);
+  const qint64 time = qMax(summary.lastMessageTime, summary.lastCallTime);
+  if (time == 0)
+    return;
+
+  auto it = mSipAddresses.find(sipAddress);
+  if (it == mSipAddresses.end())
+    return;
+
+  (*it)["timestamp"] = QDateTime::fromMSecsSinceEpoch(time * 1000);
+
+  int row = mRowIndex.value(&(*it), -1);
+  Q_ASSERT(row != -1);
+  emit dataChanged(index(row, 0), index(row, 0));
+}
+
+bool SipAddressesModel::loadTimelineSummary () {
+  const QString path = ::Utils::coreStringToAppString(Paths::getTimelineSummaryFilePath());
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+    return false;
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  quint32 magic, version, count;
+  stream >> magic >> version >> count;
+  if (magic != TIMELINE_SUMMARY_MAGIC || version != TIMELINE_SUMMARY_VERSION) {
+    qWarning() << QStringLiteral("Unsupported timeline summary: `%1`.").arg(path);
+    return false;
+  }
+
+  QHash<QString, TimelineSummary> timelineSummary;
+  for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+    QString sipAddress;
+    TimelineSummary summary;
+    stream >> sipAddress >> summary.lastMessageTime >> summary.lastCallTime;
+    timelineSummary[sipAddress] = summary;
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    qWarning() << QStringLiteral("Invalid timeline summary: `%1`.").arg(path);
+    return false;
+  }
+
+  mTimelineSummary = timelineSummary;
+  return true;
+}
+
+void SipAddressesModel::saveTimelineSummary () {
+  const QString path = ::Utils::coreStringToAppString(Paths::getTimelineSummaryFilePath());
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << QStringLiteral("Unable to save timeline summary: `%1`.").arg(path);
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  stream << quint32(TIMELINE_SUMMARY_MAGIC) << quint32(TIMELINE_SUMMARY_VERSION) << quint32(mTimelineSummary.count());
+  for (auto it = mTimelineSummary.cbegin(); it != mTimelineSummary.cend(); ++it)
+    stream << it.key() << it->lastMessageTime << it->lastCallTime;
+
+  if (stream.status() != QDataStream::Ok || !file.commit())
+    qWarning() << QStringLiteral("Unable to save timeline summary: `%1`.").arg(path);
+}
+
+// -----------------------------------------------------------------------------
+
 void SipAddressesModel::updateObservers (const QString &sipAddress, ContactModel *contact) {
   for (auto &observer : mObservers.values(sipAddress))
     observer->setContact(contact);
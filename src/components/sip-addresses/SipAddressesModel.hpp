@@ -26,10 +26,13 @@
 #include <QAbstractListModel>
 #include <QUrl>
 
+#include "../../utils/SearchIndex.hpp"
 #include "SipAddressObserver.hpp"
 
 // =============================================================================
 
+class QTimer;
+
 class ChatModel;
 class CoreHandlers;
 
@@ -37,14 +40,27 @@ class SipAddressesModel : public QAbstractListModel {
   Q_OBJECT;
 
 public:
+  enum Roles {
+    Entry = Qt::DisplayRole, // A `QVariantMap` copy, use the typed roles in C++.
+
+    SipAddress = Qt::UserRole,
+    Contact,
+    Timestamp
+  };
+
   SipAddressesModel (QObject *parent = Q_NULLPTR);
-  ~SipAddressesModel () = default;
+  ~SipAddressesModel ();
 
   int rowCount (const QModelIndex &index = QModelIndex()) const override;
 
   QHash<int, QByteArray> roleNames () const override;
   QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
+  // Sip addresses and usernames of the mapped contacts.
+  const SearchIndex<QString> &getSearchIndex () const {
+    return mSearchIndex;
+  }
+
   Q_INVOKABLE QVariantMap find (const QString &sipAddress) const;
   Q_INVOKABLE ContactModel *mapSipAddressToContact (const QString &sipAddress) const;
   Q_INVOKABLE SipAddressObserver *getSipAddressObserver (const QString &sipAddress);
@@ -73,6 +89,7 @@ private:
 
   void handleContactAdded (ContactModel *contact);
   void handleContactRemoved (const ContactModel *contact);
+  void handleContactUpdated (ContactModel *contact);
 
   void handleSipAddressAdded (ContactModel *contact, const QString &sipAddress);
   void handleSipAddressRemoved (ContactModel *contact, const QString &sipAddress);
@@ -80,8 +97,11 @@ private:
   void handleMessageReceived (const std::shared_ptr<linphone::ChatMessage> &message);
   void handleCallStateChanged (const std::shared_ptr<linphone::Call> &call, linphone::CallState state);
   void handlePresenceReceived (const QString &sipAddress, const std::shared_ptr<const linphone::PresenceModel> &presenceModel);
+  void signalPresenceChanges ();
 
   void handleAllEntriesRemoved (const QString &sipAddress);
+  void handleMessageRemoved (const std::shared_ptr<linphone::ChatMessage> &message);
+  void handleCallLogsRemoved (const QString &sipAddress, const std::list<std::shared_ptr<linphone::CallLog> > &callLogs);
   void handleMessageSent (const std::shared_ptr<linphone::ChatMessage> &message);
   void handleMessagesCountReset (const QString &sipAddress);
 
@@ -102,17 +122,48 @@ private:
 
   void removeContactOfSipAddress (const QString &sipAddress);
 
+  void indexSipAddress (const QVariantMap &map);
+
   void initSipAddresses ();
 
+  // ---------------------------------------------------------------------------
+
+  // Last activities of each sip address, persisted to avoid reading all the history at startup.
+  struct TimelineSummary {
+    qint64 lastMessageTime = 0; // In seconds.
+    qint64 lastCallTime = 0; // In seconds.
+  };
+
+  void updateTimelineSummary (const QString &sipAddress, qint64 lastMessageTime, qint64 lastCallTime);
+  void removeTimelineSummary (const QString &sipAddress);
+
+  // Update the timestamp of a sip address after the removal of its last activity.
+  void signalTimelineSummaryDecrease (const QString &sipAddress);
+
+  bool loadTimelineSummary ();
+  void saveTimelineSummary ();
+
+  // ---------------------------------------------------------------------------
+
   void updateObservers (const QString &sipAddress, ContactModel *contact);
   void updateObservers (const QString &sipAddress, const Presence::PresenceStatus &presenceStatus);
   void updateObservers (const QString &sipAddress, int messagesCount);
 
   QHash<QString, QVariantMap> mSipAddresses;
   QList<const QVariantMap *> mRefs;
+  QHash<const QVariantMap *, int> mRowIndex; // Map => row in `mRefs`.
 
   QMultiHash<QString, SipAddressObserver *> mObservers;
 
+  SearchIndex<QString> mSearchIndex;
+
+  // Presence changes not yet signaled. (Last status of each sip address.)
+  QHash<QString, Presence::PresenceStatus> mPendingPresences;
+  QTimer *mPresenceTimer = nullptr;
+
+  QHash<QString, TimelineSummary> mTimelineSummary;
+  QTimer *mTimelineSummarySaveTimer = nullptr;
+
   std::shared_ptr<CoreHandlers> mCoreHandlers;
 };
 
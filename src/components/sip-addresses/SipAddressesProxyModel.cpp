@@ -37,41 +37,80 @@ const QRegExp SipAddressesProxyModel::mSearchSeparators("^[^_.-;@ ][_.-;@ ]");
 // -----------------------------------------------------------------------------
 
 SipAddressesProxyModel::SipAddressesProxyModel (QObject *parent) : QSortFilterProxyModel(parent) {
-  setSourceModel(CoreManager::getInstance()->getSipAddressesModel());
+  SipAddressesModel *sipAddressesModel = CoreManager::getInstance()->getSipAddressesModel();
+
+  // Connected before `setSourceModel`, the weights must be removed before the update of the proxy.
+  QObject::connect(
+    sipAddressesModel, &SipAddressesModel::dataChanged,
+    this, [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+      removeWeights(QModelIndex(), topLeft.row(), bottomRight.row());
+      mCandidatesAreDirty = true;
+      for (int row = topLeft.row(); row <= bottomRight.row() && row < mRejectedRows.count(); ++row)
+        mRejectedRows[row] = false;
+    }
+  );
+  QObject::connect(
+    sipAddressesModel, &SipAddressesModel::rowsAboutToBeRemoved,
+    this, [this](const QModelIndex &parent, int first, int last) {
+      removeWeights(parent, first, last);
+      mRejectedRows.clear();
+    }
+  );
+  QObject::connect(sipAddressesModel, &SipAddressesModel::rowsAboutToBeInserted, this, [this] {
+    mRejectedRows.clear();
+    mCandidatesAreDirty = true;
+  });
+  QObject::connect(sipAddressesModel, &SipAddressesModel::modelAboutToBeReset, this, [this] {
+    mWeights.clear();
+    mRejectedRows.clear();
+    mCandidatesAreDirty = true;
+  });
+
+  setSourceModel(sipAddressesModel);
   sort(0);
 }
 
 // -----------------------------------------------------------------------------
 
 void SipAddressesProxyModel::setFilter (const QString &pattern) {
+  // A row which doesn't contain the old pattern can't contain an extended one.
+  // Otherwise a full pass is necessary.
+  if (!pattern.startsWith(mFilter, Qt::CaseInsensitive))
+    mRejectedRows.clear();
+
   mFilter = pattern;
+  mWeights.clear();
+  mCandidatesAreDirty = true;
   invalidate();
 }
 
 // -----------------------------------------------------------------------------
 
 bool SipAddressesProxyModel::filterAcceptsRow (int sourceRow, const QModelIndex &sourceParent) const {
-  const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-  return computeEntryWeight(index.data().toMap()) > 0;
+  if (sourceRow < mRejectedRows.count() && mRejectedRows[sourceRow])
+    return false;
+
+  const bool accepted = getEntryWeight(sourceModel()->index(sourceRow, 0, sourceParent)) > 0;
+  if (mRejectedRows.count() != sourceModel()->rowCount())
+    mRejectedRows.fill(false, sourceModel()->rowCount());
+  mRejectedRows[sourceRow] = !accepted;
+
+  return accepted;
 }
 
 bool SipAddressesProxyModel::lessThan (const QModelIndex &left, const QModelIndex &right) const {
-  const QVariantMap mapA = sourceModel()->data(left).toMap();
-  const QVariantMap mapB = sourceModel()->data(right).toMap();
-
-  const QString sipAddressA = mapA["sipAddress"].toString();
-  const QString sipAddressB = mapB["sipAddress"].toString();
+  const QString sipAddressA = left.data(SipAddressesModel::SipAddress).toString();
+  const QString sipAddressB = right.data(SipAddressesModel::SipAddress).toString();
 
-  // TODO: Use a cache, do not compute the same value as `filterAcceptsRow`.
-  int weightA = computeEntryWeight(mapA);
-  int weightB = computeEntryWeight(mapB);
+  int weightA = getEntryWeight(left);
+  int weightB = getEntryWeight(right);
 
   // 1. Not the same weight.
   if (weightA != weightB)
     return weightA > weightB;
 
-  const ContactModel *contactA = mapA.value("contact").value<ContactModel *>();
-  const ContactModel *contactB = mapB.value("contact").value<ContactModel *>();
+  const ContactModel *contactA = left.data(SipAddressesModel::Contact).value<ContactModel *>();
+  const ContactModel *contactB = right.data(SipAddressesModel::Contact).value<ContactModel *>();
 
   // 2. No contacts.
   if (!contactA && !contactB)
@@ -94,12 +133,34 @@ bool SipAddressesProxyModel::lessThan (const QModelIndex &left, const QModelInde
   return sipAddressA <= sipAddressB;
 }
 
-int SipAddressesProxyModel::computeEntryWeight (const QVariantMap &entry) const {
-  int weight = computeStringWeight(entry["sipAddress"].toString().mid(4));
+bool SipAddressesProxyModel::isCandidate (const QString &sipAddress) const {
+  if (mCandidatesAreDirty) {
+    mUseCandidates = CoreManager::getInstance()->getSipAddressesModel()->getSearchIndex().find(mFilter, mCandidates);
+    mCandidatesAreDirty = false;
+  }
+
+  return !mUseCandidates || mCandidates.contains(sipAddress);
+}
+
+int SipAddressesProxyModel::getEntryWeight (const QModelIndex &index) const {
+  const QString sipAddress = index.data(SipAddressesModel::SipAddress).toString();
 
-  const ContactModel *contact = entry.value("contact").value<ContactModel *>();
+  auto it = mWeights.constFind(sipAddress);
+  if (it != mWeights.cend())
+    return *it;
+
+  // The weight can be positive only if the address or the username contains the filter.
+  int weight = isCandidate(sipAddress)
+    ? computeEntryWeight(sipAddress, index.data(SipAddressesModel::Contact).value<ContactModel *>())
+    : 0;
+  mWeights.insert(sipAddress, weight);
+  return weight;
+}
+
+int SipAddressesProxyModel::computeEntryWeight (const QString &sipAddress, const ContactModel *contact) const {
+  int weight = computeStringWeight(sipAddress.mid(4));
   if (contact)
-    weight += computeStringWeight(contact->getVcardModel()->getUsername());
+    weight += computeStringWeight(contact->getUsername());
 
   return weight;
 }
@@ -125,3 +186,11 @@ int SipAddressesProxyModel::computeStringWeight (const QString &string) const {
 
   return WEIGHT_POS_OTHER;
 }
+
+void SipAddressesProxyModel::removeWeights (const QModelIndex &parent, int first, int last) {
+  if (mWeights.isEmpty())
+    return;
+
+  for (int row = first; row <= last; ++row)
+    mWeights.remove(sourceModel()->index(row, 0, parent).data(SipAddressesModel::SipAddress).toString());
+}
@@ -23,10 +23,13 @@
 #ifndef SIP_ADDRESSES_PROXY_MODEL_H_
 #define SIP_ADDRESSES_PROXY_MODEL_H_
 
+#include <QSet>
 #include <QSortFilterProxyModel>
 
 // =============================================================================
 
+class ContactModel;
+
 class SipAddressesProxyModel : public QSortFilterProxyModel {
   Q_OBJECT;
 
@@ -41,11 +44,28 @@ protected:
   bool lessThan (const QModelIndex &left, const QModelIndex &right) const override;
 
 private:
-  int computeEntryWeight (const QVariantMap &entry) const;
+  bool isCandidate (const QString &sipAddress) const;
+  int getEntryWeight (const QModelIndex &index) const;
+
+  int computeEntryWeight (const QString &sipAddress, const ContactModel *contact) const;
   int computeStringWeight (const QString &string) const;
 
+  void removeWeights (const QModelIndex &parent, int first, int last);
+
   QString mFilter;
 
+  // Weights of the sip addresses for `mFilter`. Computed once per row.
+  mutable QHash<QString, int> mWeights;
+
+  // Sip addresses which contain `mFilter`, given by the search index of the source model.
+  // Not used if the filter is too short.
+  mutable QSet<QString> mCandidates;
+  mutable bool mUseCandidates = false;
+  mutable bool mCandidatesAreDirty = true;
+
+  // Source rows rejected by the current filter. Skipped when the filter is extended.
+  mutable QVector<bool> mRejectedRows;
+
   static const QRegExp mSearchSeparators;
 };
 
@@ -20,15 +20,86 @@
  *      Author: Ronan Abhamon
  */
 
+#include <algorithm>
+
+#include <QDateTime>
+#include <QTimer>
+
 #include "../core/CoreManager.hpp"
+#include "TimelineSnapshot.hpp"
 
 #include "TimelineModel.hpp"
 
+// Number of recent conversations loaded at startup.
+#define PREFETCHED_RECENT_ENTRIES 3
+
+// Time to wait on a hovered entry before loading its history.
+#define PREFETCH_HOVER_DELAY 150
+
+// Max number of entries saved for the next startup.
+#define MAX_SNAPSHOT_ENTRIES 100
+
+using namespace std;
+
 // =============================================================================
 
-TimelineModel::TimelineModel (QObject *parent) : QSortFilterProxyModel(parent) {
-  setSourceModel(CoreManager::getInstance()->getSipAddressesModel());
-  sort(0);
+inline qint64 getTimestamp (const QModelIndex &sourceIndex) {
+  const QVariant timestamp = sourceIndex.data(SipAddressesModel::Timestamp);
+  return timestamp.isValid() ? timestamp.toDateTime().toMSecsSinceEpoch() : -1;
+}
+
+// Most recent first, then sorted by sip address to get a strict order.
+inline bool isBefore (qint64 timestampA, const QString &sipAddressA, qint64 timestampB, const QString &sipAddressB) {
+  return timestampA > timestampB || (timestampA == timestampB && sipAddressA < sipAddressB);
+}
+
+// -----------------------------------------------------------------------------
+
+TimelineModel::TimelineModel (QObject *parent) : QAbstractListModel(parent) {
+  mPrefetchTimer = new QTimer(this);
+  mPrefetchTimer->setSingleShot(true);
+  mPrefetchTimer->setInterval(PREFETCH_HOVER_DELAY);
+  QObject::connect(mPrefetchTimer, &QTimer::timeout, this, [this] {
+    CoreManager::getInstance()->prefetchChatModel(mPrefetchSipAddress);
+  });
+
+  CoreManager *coreManager = CoreManager::getInstance();
+  if (coreManager->isStarted()) {
+    handleCoreStarted();
+    return;
+  }
+
+  // Display the last known entries until the core is started.
+  for (const auto &snapshotEntry : TimelineSnapshot::load()) {
+    QVariantMap map;
+    map["sipAddress"] = snapshotEntry.sipAddress;
+    map["timestamp"] = QDateTime::fromMSecsSinceEpoch(snapshotEntry.timestamp);
+    map["unreadMessagesCount"] = snapshotEntry.unreadMessagesCount;
+
+    // Same properties as a `ContactModel` for the views.
+    if (!snapshotEntry.username.isEmpty()) {
+      QVariantMap vcard;
+      vcard["username"] = snapshotEntry.username;
+      vcard["avatar"] = snapshotEntry.avatar;
+
+      QVariantMap contact;
+      contact["vcard"] = vcard;
+      map["contact"] = contact;
+    }
+
+    mSnapshotEntries << map;
+  }
+
+  QObject::connect(coreManager, &CoreManager::coreStarted, this, &TimelineModel::handleCoreStarted);
+}
+
+TimelineModel::~TimelineModel () {
+  if (mIsStarted)
+    saveSnapshot();
+}
+
+int TimelineModel::rowCount (const QModelIndex &) const {
+  return mIsStarted ? mEntries.count() : mSnapshotEntries.count();
 }
 
 QHash<int, QByteArray> TimelineModel::roleNames () const {
@@ -37,13 +108,232 @@ QHash<int, QByteArray> TimelineModel::roleNames () const {
   return roles;
 }
 
+QVariant TimelineModel::data (const QModelIndex &index, int role) const {
+  int row = index.row();
+
+  if (!index.isValid() || row < 0 || row >= rowCount())
+    return QVariant();
+
+  if (!mIsStarted)
+    return role == Qt::DisplayRole ? mSnapshotEntries[row] : QVariant();
+
+  return mEntries[row].sourceIndex.data(role);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimelineModel::prefetch (int row) {
+  cancelPrefetch();
+  if (!mIsStarted)
+    return;
+
+  mPrefetchSipAddress = getSipAddress(row);
+  if (!mPrefetchSipAddress.isEmpty())
+    mPrefetchTimer->start();
+}
+
+void TimelineModel::cancelPrefetch () {
+  mPrefetchTimer->stop();
+  if (!mPrefetchSipAddress.isEmpty()) {
+    CoreManager::getInstance()->cancelChatModelPrefetch(mPrefetchSipAddress);
+    mPrefetchSipAddress.clear();
+  }
+}
+
+void TimelineModel::prefetchRecentEntries () {
+  const int count = qMin(rowCount(), PREFETCHED_RECENT_ENTRIES);
+  for (int row = 0; row < count; ++row)
+    CoreManager::getInstance()->prefetchChatModel(getSipAddress(row));
+}
+
+QString TimelineModel::getSipAddress (int row) const {
+  return row >= 0 && row < mEntries.count() ? mEntries[row].sipAddress : QString("");
+}
+
+// -----------------------------------------------------------------------------
+
+void TimelineModel::handleSourceRowsInserted (const QModelIndex &parent, int first, int last) {
+  const QAbstractItemModel *sourceModel = CoreManager::getInstance()->getSipAddressesModel();
+  for (int row = first; row <= last; ++row) {
+    const QModelIndex sourceIndex = sourceModel->index(row, 0, parent);
+    const qint64 timestamp = ::getTimestamp(sourceIndex);
+    if (timestamp != -1)
+      insertEntry(sourceIndex, timestamp);
+  }
+}
+
+void TimelineModel::handleSourceRowsAboutToBeRemoved (const QModelIndex &parent, int first, int last) {
+  const QAbstractItemModel *sourceModel = CoreManager::getInstance()->getSipAddressesModel();
+  for (int row = first; row <= last; ++row) {
+    int entryRow = findRow(sourceModel->index(row, 0, parent).data(SipAddressesModel::SipAddress).toString());
+    if (entryRow != -1)
+      removeEntry(entryRow);
+  }
+}
+
+void TimelineModel::handleSourceDataChanged (const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+  const QAbstractItemModel *sourceModel = CoreManager::getInstance()->getSipAddressesModel();
+  for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+    const QModelIndex sourceIndex = sourceModel->index(row, 0, topLeft.parent());
+    const QString sipAddress = sourceIndex.data(SipAddressesModel::SipAddress).toString();
+    const qint64 timestamp = ::getTimestamp(sourceIndex);
+
+    int entryRow = findRow(sipAddress);
+    if (entryRow == -1) {
+      if (timestamp != -1)
+        insertEntry(sourceIndex, timestamp);
+      continue;
+    }
+
+    if (timestamp == -1) {
+      removeEntry(entryRow);
+      continue;
+    }
+
+    if (timestamp != mEntries[entryRow].timestamp) {
+      moveEntry(entryRow, timestamp);
+      entryRow = findRow(sipAddress);
+    }
+
+    emit dataChanged(index(entryRow, 0), index(entryRow, 0));
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimelineModel::handleCoreStarted () {
+  SipAddressesModel *sipAddressesModel = CoreManager::getInstance()->getSipAddressesModel();
+
+  QObject::connect(sipAddressesModel, &SipAddressesModel::rowsInserted, this, &TimelineModel::handleSourceRowsInserted);
+  QObject::connect(
+    sipAddressesModel, &SipAddressesModel::rowsAboutToBeRemoved,
+    this, &TimelineModel::handleSourceRowsAboutToBeRemoved
+  );
+  QObject::connect(sipAddressesModel, &SipAddressesModel::dataChanged, this, &TimelineModel::handleSourceDataChanged);
+  QObject::connect(sipAddressesModel, &SipAddressesModel::modelReset, this, &TimelineModel::initEntries);
+  QObject::connect(sipAddressesModel, &SipAddressesModel::layoutChanged, this, &TimelineModel::initEntries);
+
+  // Replace the snapshot by the live entries.
+  initEntries();
+
+  // Wait the first display of the timeline.
+  QTimer::singleShot(0, this, &TimelineModel::prefetchRecentEntries);
+}
+
 // -----------------------------------------------------------------------------
 
-bool TimelineModel::filterAcceptsRow (int sourceRow, const QModelIndex &sourceParent) const {
-  const QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-  return index.data().toMap().contains("timestamp");
+void TimelineModel::initEntries () {
+  const QAbstractItemModel *sourceModel = CoreManager::getInstance()->getSipAddressesModel();
+
+  beginResetModel();
+
+  mIsStarted = true;
+  mSnapshotEntries.clear();
+
+  mEntries.clear();
+  mTimestamps.clear();
+
+  for (int row = 0, count = sourceModel->rowCount(); row < count; ++row) {
+    const QModelIndex sourceIndex = sourceModel->index(row, 0);
+    const qint64 timestamp = ::getTimestamp(sourceIndex);
+    if (timestamp == -1)
+      continue;
+
+    const QString sipAddress = sourceIndex.data(SipAddressesModel::SipAddress).toString();
+    mEntries << Entry{ QPersistentModelIndex(sourceIndex), sipAddress, timestamp };
+    mTimestamps[sipAddress] = timestamp;
+  }
+
+  // `std::` is necessary, `QAbstractItemModel::sort` hides it.
+  std::sort(mEntries.begin(), mEntries.end(), [](const Entry &a, const Entry &b) {
+    return ::isBefore(a.timestamp, a.sipAddress, b.timestamp, b.sipAddress);
+  });
+
+  endResetModel();
+}
+
+void TimelineModel::saveSnapshot () const {
+  QVector<TimelineSnapshot::Entry> snapshotEntries;
+
+  for (const auto &entry : mEntries) {
+    if (snapshotEntries.count() == MAX_SNAPSHOT_ENTRIES)
+      break;
+
+    const QVariantMap map = entry.sourceIndex.data().toMap();
+    if (map.isEmpty())
+      continue;
+
+    TimelineSnapshot::Entry snapshotEntry;
+    snapshotEntry.sipAddress = entry.sipAddress;
+    snapshotEntry.timestamp = entry.timestamp;
+    snapshotEntry.unreadMessagesCount = map.value("unreadMessagesCount").toInt();
+
+    // Saved at exit, the vcard models of the contacts are not created.
+    const ContactModel *contact = map.value("contact").value<ContactModel *>();
+    if (contact) {
+      snapshotEntry.username = contact->getUsername();
+      snapshotEntry.avatar = contact->getAvatar();
+    }
+
+    snapshotEntries << snapshotEntry;
+  }
+
+  TimelineSnapshot::save(snapshotEntries);
+}
+
+void TimelineModel::insertEntry (const QModelIndex &sourceIndex, qint64 timestamp) {
+  const QString sipAddress = sourceIndex.data(SipAddressesModel::SipAddress).toString();
+  int row = findInsertionRow(sipAddress, timestamp);
+
+  beginInsertRows(QModelIndex(), row, row);
+  mEntries.insert(row, Entry{ QPersistentModelIndex(sourceIndex), sipAddress, timestamp });
+  mTimestamps[sipAddress] = timestamp;
+  endInsertRows();
+}
+
+void TimelineModel::removeEntry (int row) {
+  beginRemoveRows(QModelIndex(), row, row);
+  mTimestamps.remove(mEntries[row].sipAddress);
+  mEntries.remove(row);
+  endRemoveRows();
+}
+
+void TimelineModel::moveEntry (int row, qint64 timestamp) {
+  const QString sipAddress = mEntries[row].sipAddress;
+  mTimestamps[sipAddress] = timestamp;
+
+  // Destination before the move. (The entries are still sorted with the old timestamp.)
+  int destinationRow = findInsertionRow(sipAddress, timestamp);
+  if (destinationRow == row || destinationRow == row + 1) {
+    mEntries[row].timestamp = timestamp;
+    return;
+  }
+
+  beginMoveRows(QModelIndex(), row, row, QModelIndex(), destinationRow);
+  Entry entry = mEntries.takeAt(row);
+  entry.timestamp = timestamp;
+  mEntries.insert(destinationRow > row ? destinationRow - 1 : destinationRow, entry);
+  endMoveRows();
+}
+
+// -----------------------------------------------------------------------------
+
+int TimelineModel::findRow (const QString &sipAddress) const {
+  auto it = mTimestamps.constFind(sipAddress);
+  if (it == mTimestamps.cend())
+    return -1;
+
+  int row = findInsertionRow(sipAddress, *it);
+  Q_ASSERT(row < mEntries.count() && mEntries[row].sipAddress == sipAddress);
+  return row;
 }
 
-bool TimelineModel::lessThan (const QModelIndex &left, const QModelIndex &right) const {
-  return sourceModel()->data(left).toMap()["timestamp"] > sourceModel()->data(right).toMap()["timestamp"];
+int TimelineModel::findInsertionRow (const QString &sipAddress, qint64 timestamp) const {
+  auto it = lower_bound(
+      mEntries.cbegin(), mEntries.cend(), timestamp,
+      [&sipAddress](const Entry &entry, qint64 timestamp) {
+        return ::isBefore(entry.timestamp, entry.sipAddress, timestamp, sipAddress);
+      }
+    );
+  return static_cast<int>(it - mEntries.cbegin());
 }
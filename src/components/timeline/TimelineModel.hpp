@@ -23,22 +23,67 @@
 #ifndef TIMELINE_MODEL_H_
 #define TIMELINE_MODEL_H_
 
-#include <QSortFilterProxyModel>
+#include <QAbstractListModel>
 
 // =============================================================================
+// Sip addresses with a timestamp, the most recent first.
+// The entries are kept sorted, an update moves only the updated row.
+// =============================================================================
+
+class QTimer;
 
-class TimelineModel : public QSortFilterProxyModel {
+class TimelineModel : public QAbstractListModel {
   Q_OBJECT;
 
 public:
   TimelineModel (QObject *parent = Q_NULLPTR);
-  ~TimelineModel () = default;
+  ~TimelineModel ();
+
+  int rowCount (const QModelIndex &index = QModelIndex()) const override;
 
   QHash<int, QByteArray> roleNames () const override;
+  QVariant data (const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+  // Load the history of a hovered entry if the pointer stays on it.
+  Q_INVOKABLE void prefetch (int row);
+  Q_INVOKABLE void cancelPrefetch ();
+
+private:
+  struct Entry {
+    QPersistentModelIndex sourceIndex;
+    QString sipAddress;
+    qint64 timestamp; // In ms.
+  };
+
+  void handleSourceRowsInserted (const QModelIndex &parent, int first, int last);
+  void handleSourceRowsAboutToBeRemoved (const QModelIndex &parent, int first, int last);
+  void handleSourceDataChanged (const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+  void handleCoreStarted ();
+
+  void initEntries ();
+  void saveSnapshot () const;
+
+  void insertEntry (const QModelIndex &sourceIndex, qint64 timestamp);
+  void removeEntry (int row);
+  void moveEntry (int row, qint64 timestamp);
+
+  int findRow (const QString &sipAddress) const;
+  int findInsertionRow (const QString &sipAddress, qint64 timestamp) const;
+
+  void prefetchRecentEntries ();
+
+  QString getSipAddress (int row) const;
+
+  QVector<Entry> mEntries;
+  QHash<QString, qint64> mTimestamps;
+
+  // Read only entries displayed until the core is started.
+  QVector<QVariantMap> mSnapshotEntries;
+  bool mIsStarted = false;
 
-protected:
-  bool filterAcceptsRow (int sourceRow, const QModelIndex &sourceParent) const override;
-  bool lessThan (const QModelIndex &left, const QModelIndex &right) const override;
+  QString mPrefetchSipAddress;
+  QTimer *mPrefetchTimer = nullptr;
 };
 
 #endif // TIMELINE_MODEL_H_
@@ -0,0 +1,108 @@
+/*
+ * TimelineSnapshot.cpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 14, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtDebug>
+
+#include "../../app/paths/Paths.hpp"
+#include "../../utils/Utils.hpp"
+
+#include "TimelineSnapshot.hpp"
+
+#define TIMELINE_SNAPSHOT_MAGIC 0x4C54534E
+#define TIMELINE_SNAPSHOT_VERSION 1
+
+// =============================================================================
+
+inline QString getFilePath () {
+  return ::Utils::coreStringToAppString(Paths::getTimelineSnapshotFilePath());
+}
+
+bool TimelineSnapshot::exists () {
+  return QFileInfo(::getFilePath()).size() > 0;
+}
+
+QVector<TimelineSnapshot::Entry> TimelineSnapshot::load () {
+  const QString path = ::getFilePath();
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+    return QVector<Entry>();
+
+  // The snapshot is read before the first paint, avoid a copy of the file.
+  uchar *data = file.map(0, file.size());
+  if (!data) {
+    qWarning() << QStringLiteral("Unable to map timeline snapshot: `%1`.").arg(path);
+    return QVector<Entry>();
+  }
+
+  const QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), static_cast<int>(file.size()));
+  QDataStream stream(bytes);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  QVector<Entry> entries;
+
+  quint32 magic, version, count;
+  stream >> magic >> version >> count;
+  if (magic != TIMELINE_SNAPSHOT_MAGIC || version != TIMELINE_SNAPSHOT_VERSION)
+    qWarning() << QStringLiteral("Unsupported timeline snapshot: `%1`.").arg(path);
+  else {
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+      Entry entry;
+      qint32 unreadMessagesCount;
+      stream >> entry.sipAddress >> entry.timestamp >> unreadMessagesCount >> entry.username >> entry.avatar;
+      entry.unreadMessagesCount = unreadMessagesCount;
+      entries << entry;
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+      qWarning() << QStringLiteral("Invalid timeline snapshot: `%1`.").arg(path);
+      entries.clear();
+    }
+  }
+
+  file.unmap(data);
+  return entries;
+}
+
+void TimelineSnapshot::save (const QVector<Entry> &entries) {
+  const QString path = ::getFilePath();
+
+  QSaveFile file(path);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qWarning() << QStringLiteral("Unable to save timeline snapshot: `%1`.").arg(path);
+    return;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(QDataStream::Qt_5_0);
+
+  stream << quint32(TIMELINE_SNAPSHOT_MAGIC) << quint32(TIMELINE_SNAPSHOT_VERSION) << quint32(entries.count());
+  for (const auto &entry : entries)
+    stream << entry.sipAddress << entry.timestamp << qint32(entry.unreadMessagesCount) << entry.username << entry.avatar;
+
+  if (stream.status() != QDataStream::Ok || !file.commit())
+    qWarning() << QStringLiteral("Unable to save timeline snapshot: `%1`.").arg(path);
+}
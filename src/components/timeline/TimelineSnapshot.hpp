@@ -0,0 +1,51 @@
+/*
+ * TimelineSnapshot.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 14, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef TIMELINE_SNAPSHOT_H_
+#define TIMELINE_SNAPSHOT_H_
+
+#include <QString>
+#include <QVector>
+
+// =============================================================================
+// Entries of the timeline saved at exit. Displayed at startup before the
+// creation of the linphone core, replaced by the live entries once started.
+// =============================================================================
+
+namespace TimelineSnapshot {
+  struct Entry {
+    QString sipAddress;
+    qint64 timestamp = 0; // In ms.
+    int unreadMessagesCount = 0;
+
+    // Contact of the sip address, empty if there is no contact.
+    QString username;
+    QString avatar;
+  };
+
+  bool exists ();
+
+  QVector<Entry> load ();
+  void save (const QVector<Entry> &entries);
+}
+
+#endif // TIMELINE_SNAPSHOT_H_
@@ -1368,6 +1368,15 @@ QImage QExifImageHeader::thumbnail() const
     return image;
 }
 
+/*!
+    Returns the orientation of the thumbnail. If it is set, thumbnail() returns an image already
+    transformed with it.
+*/
+QExifValue QExifImageHeader::thumbnailOrientation() const
+{
+    return d->thumbnailOrientation;
+}
+
 /*!
     Sets the image \a thumbnail.
 */
@@ -1400,28 +1409,39 @@ QByteArray QExifImageHeader::extractExif( QIODevice *device ) const
     if( device->read( 2 ) != "\xFF\xD8" )
         return QByteArray();
 
-    while( device->read( 2 ) != "\xFF\xE1" )
+    // The EXIF data is in an APP1 segment placed before the image data. Stop at the first
+    // segment which is not an APPn or a comment, there is no need to read the whole file.
+    forever
     {
-        if( device->atEnd() )
+        QByteArray marker = device->read( 2 );
+
+        if( marker.size() != 2 || quint8( marker.at( 0 ) ) != 0xFF )
             return QByteArray();
 
-        quint16 length;
+        quint8 type = quint8( marker.at( 1 ) );
 
-        stream >> length;
-
-        device->seek( device->pos() + length - 2 );
-    }
+        if( ( type < 0xE0 || type > 0xEF ) && type != 0xFE )
+            return QByteArray();
 
-    quint16 length;
+        quint16 length;
 
-    stream >> length;
+        stream >> length;
 
-    if( device->read( 4 ) != "Exif" )
-        return QByteArray();
+        if( stream.status() != QDataStream::Ok || length < 2 )
+            return QByteArray();
 
-    device->read( 2 );
+        if( type == 0xE1 && length >= 8 )
+        {
+            if( device->read( 6 ) == QByteArray( "Exif\0\0", 6 ) )
+                return device->read( length - 8 );
 
-    return device->read( length - 8 );
+            // Other APP1 segment. (XMP...)
+            if( !device->seek( device->pos() + length - 8 ) )
+                return QByteArray();
+        }
+        else if( !device->seek( device->pos() + length - 2 ) )
+            return QByteArray();
+    }
 }
 
 
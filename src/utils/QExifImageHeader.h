@@ -307,6 +307,7 @@ public:
     void setValue(GpsTag tag, const QExifValue &value);
 
     QImage thumbnail() const;
+    QExifValue thumbnailOrientation() const;
     void setThumbnail( const QImage &thumbnail );
 
 private:
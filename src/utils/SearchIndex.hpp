@@ -0,0 +1,149 @@
+/*
+ * SearchIndex.hpp
+ * Copyright (C) 2017  Belledonne Communications, Grenoble, France
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ *  Created on: July 14, 2017
+ *      Author: Ronan Abhamon
+ */
+
+#ifndef SEARCH_INDEX_H_
+#define SEARCH_INDEX_H_
+
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+// =============================================================================
+// Trigram index of the strings of keys. (Sip addresses, contacts...)
+// Returns the keys which have a string containing a pattern, case insensitive.
+// =============================================================================
+
+template<class Key>
+class SearchIndex {
+public:
+  // Replace the strings of a key.
+  void insert (const Key &key, const QStringList &strings) {
+    remove(key);
+
+    quint32 id;
+    if (mFreeIds.isEmpty()) {
+      id = static_cast<quint32>(mDocuments.count());
+      mDocuments.append(Document());
+    } else
+      id = mFreeIds.takeLast();
+
+    Document &document = mDocuments[static_cast<int>(id)];
+    document.key = key;
+
+    QSet<quint64> trigrams;
+    for (const auto &string : strings) {
+      const QString folded = string.toCaseFolded();
+      document.strings << folded;
+      for (int i = 0; i + 2 < folded.length(); ++i)
+        trigrams << getTrigram(folded, i);
+    }
+
+    for (const auto &trigram : trigrams)
+      mPostings[trigram] << id;
+
+    mIds.insert(key, id);
+  }
+
+  void remove (const Key &key) {
+    auto it = mIds.find(key);
+    if (it == mIds.end())
+      return;
+
+    const quint32 id = *it;
+    mIds.erase(it);
+
+    Document &document = mDocuments[static_cast<int>(id)];
+    for (const auto &string : document.strings)
+      for (int i = 0; i + 2 < string.length(); ++i) {
+        auto postingIt = mPostings.find(getTrigram(string, i));
+        if (postingIt == mPostings.end())
+          continue;
+
+        postingIt->removeOne(id);
+        if (postingIt->isEmpty())
+          mPostings.erase(postingIt);
+      }
+
+    document = Document();
+    mFreeIds << id;
+  }
+
+  void clear () {
+    mIds.clear();
+    mDocuments.clear();
+    mFreeIds.clear();
+    mPostings.clear();
+  }
+
+  // Returns false if the pattern is too short to use the index. (All keys are candidates.)
+  bool find (const QString &pattern, QSet<Key> &keys) const {
+    keys.clear();
+
+    const QString folded = pattern.toCaseFolded();
+    if (folded.length() < 3)
+      return false;
+
+    // Only the documents of the rarest trigram are checked.
+    const QVector<quint32> *candidates = nullptr;
+    for (int i = 0; i + 2 < folded.length(); ++i) {
+      auto it = mPostings.constFind(getTrigram(folded, i));
+      if (it == mPostings.cend())
+        return true;
+
+      if (!candidates || it->count() < candidates->count())
+        candidates = &(*it);
+    }
+
+    for (const auto &id : *candidates) {
+      const Document &document = mDocuments.at(static_cast<int>(id));
+      for (const auto &string : document.strings)
+        if (string.contains(folded)) {
+          keys << document.key;
+          break;
+        }
+    }
+
+    return true;
+  }
+
+private:
+  struct Document {
+    Key key = Key();
+    QStringList strings; // Case folded.
+  };
+
+  static quint64 getTrigram (const QString &string, int i) {
+    return (quint64(string.at(i).unicode()) << 32) |
+      (quint64(string.at(i + 1).unicode()) << 16) |
+      quint64(string.at(i + 2).unicode());
+  }
+
+  QHash<Key, quint32> mIds;
+  QVector<Document> mDocuments;
+  QVector<quint32> mFreeIds;
+
+  // Trigram => ids of the documents which contain it. (Once per document.)
+  QHash<quint64, QVector<quint32> > mPostings;
+};
+
+#endif // SEARCH_INDEX_H_
@@ -15,6 +15,17 @@ function initView () {
   chat.bindToEnd = true
 }
 
+function displayMessage (timestamp, content) {
+  // Not found or hidden by the entry type filter.
+  var index = container.proxyModel.loadMessageEntry(timestamp, content)
+  if (index === -1) {
+    return
+  }
+
+  chat.bindToEnd = false
+  chat.positionViewAtIndex(index, QtQuick.ListView.Center)
+}
+
 function loadMoreEntries () {
   if (chat.atYBeginning && !chat.tryToLoadMoreEntries) {
     chat.tryToLoadMoreEntries = true
@@ -23,16 +34,16 @@ function loadMoreEntries () {
   }
 }
 
-function getComponentFromEntry (chatEntry) {
-  if (chatEntry.fileName) {
+function getComponentFromEntry (type, fileName, isOutgoing) {
+  if (fileName) {
     return 'FileMessage.qml'
   }
 
-  if (chatEntry.type === Linphone.ChatModel.CallEntry) {
+  if (type === Linphone.ChatModel.CallEntry) {
     return 'Event.qml'
   }
 
-  return chatEntry.isOutgoing ? 'OutgoingMessage.qml' : 'IncomingMessage.qml'
+  return isOutgoing ? 'OutgoingMessage.qml' : 'IncomingMessage.qml'
 }
 
 function getIsComposingMessage () {
@@ -53,7 +64,10 @@ function handleFilesDropped (files) {
 }
 
 function handleMoreEntriesLoaded (n) {
-  chat.positionViewAtIndex(n - 1, QtQuick.ListView.Beginning)
+  // No entry can be added. (Fetched page without entry of the filtered type.)
+  if (n > 0) {
+    chat.positionViewAtIndex(n - 1, QtQuick.ListView.Beginning)
+  }
   chat.tryToLoadMoreEntries = false
 }
 
@@ -15,12 +15,21 @@ Rectangle {
 
   property alias proxyModel: chat.model
 
+  // Optional message to display when the chat is loaded: { timestamp, content }.
+  property var initialMessage
+
   // ---------------------------------------------------------------------------
 
   signal messageToSend (string text)
 
   // ---------------------------------------------------------------------------
 
+  function displayMessage (timestamp, content) {
+    Logic.displayMessage(timestamp, content)
+  }
+
+  // ---------------------------------------------------------------------------
+
   color: ChatStyle.color
 
   ColumnLayout {
@@ -51,7 +60,14 @@ Rectangle {
 
       // -----------------------------------------------------------------------
 
-      Component.onCompleted: Logic.initView()
+      Component.onCompleted: {
+        Logic.initView()
+
+        var message = container.initialMessage
+        if (message) {
+          Logic.displayMessage(message.timestamp, message.content)
+        }
+      }
 
       onContentYChanged: Logic.loadMoreEntries()
       onMovementEnded: Logic.handleMovementEnded()
@@ -167,7 +183,7 @@ Rectangle {
               color: ChatStyle.entry.time.color
               font.pointSize: ChatStyle.entry.time.pointSize
 
-              text: $chatEntry.timestamp.toLocaleString(
+              text: $timestamp.toLocaleString(
                 Qt.locale(App.locale),
                 'hh:mm'
               )
@@ -175,14 +191,14 @@ Rectangle {
               verticalAlignment: Text.AlignVCenter
 
               TooltipArea {
-                text: $chatEntry.timestamp.toLocaleString(Qt.locale(App.locale))
+                text: $timestamp.toLocaleString(Qt.locale(App.locale))
               }
             }
 
             // Display content.
             Loader {
               Layout.fillWidth: true
-              source: Logic.getComponentFromEntry($chatEntry)
+              source: Logic.getComponentFromEntry($type, $fileName, $isOutgoing)
             }
           }
         }
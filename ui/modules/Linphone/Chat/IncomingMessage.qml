@@ -40,7 +40,7 @@ RowLayout {
         // 4. One hour between two incoming messages. => Visible.
         return previousEntry.type !== ChatModel.MessageEntry ||
           previousEntry.isOutgoing ||
-          $chatEntry.timestamp.getTime() - previousEntry.timestamp.getTime() > 3600
+          $timestamp.getTime() - previousEntry.timestamp.getTime() > 3600
       }
     }
   }
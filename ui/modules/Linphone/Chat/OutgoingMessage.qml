@@ -38,9 +38,9 @@ Item {
             ChatModel.MessageStatusIdle,
             ChatModel.MessageStatusInProgress,
             ChatModel.MessageStatusNotDelivered
-          ], $chatEntry.status)
+          ], $status)
 
-          readonly property bool isRead: $chatEntry.status === ChatModel.MessageStatusDisplayed
+          readonly property bool isRead: $status === ChatModel.MessageStatusDisplayed
 
           icon: isNotDelivered
             ? 'chat_error'
@@ -69,7 +69,7 @@ Item {
         height: ChatStyle.entry.lineHeight
         width: ChatStyle.entry.message.outgoing.sendIconSize
 
-        sourceComponent: $chatEntry.status === ChatModel.MessageStatusInProgress
+        sourceComponent: $status === ChatModel.MessageStatusInProgress
           ? indicator
           : icon
       }
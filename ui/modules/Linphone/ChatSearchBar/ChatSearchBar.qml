@@ -0,0 +1,108 @@
+import QtQuick 2.7
+import QtQuick.Layouts 1.3
+
+import Common 1.0
+import Linphone 1.0
+
+import Linphone.Styles 1.0
+
+// =============================================================================
+
+SearchBox {
+  id: searchBox
+
+  // ---------------------------------------------------------------------------
+
+  signal hitClicked (string sipAddress, var timestamp, string content)
+
+  // ---------------------------------------------------------------------------
+
+  entryHeight: ChatSearchBarStyle.entry.height
+
+  // ---------------------------------------------------------------------------
+
+  ScrollableListView {
+    id: view
+
+    model: ChatSearchModel {}
+
+    onAtYEndChanged: atYEnd && model.loadMoreHits()
+
+    delegate: Rectangle {
+      id: hitEntry
+
+      color: ChatSearchBarStyle.entry.color.normal
+      height: ChatSearchBarStyle.entry.height
+      width: parent ? parent.width : 0
+
+      MouseArea {
+        id: mouseArea
+
+        anchors.fill: parent
+        cursorShape: Qt.PointingHandCursor
+        hoverEnabled: true
+
+        onClicked: {
+          searchBox.closeMenu()
+          searchBox.hitClicked($sipAddress, $timestamp, $content)
+        }
+
+        RowLayout {
+          anchors {
+            fill: parent
+            rightMargin: ChatSearchBarStyle.entry.rightMargin
+          }
+          spacing: ChatSearchBarStyle.entry.spacing
+
+          Contact {
+            Layout.fillHeight: true
+            Layout.preferredWidth: ChatSearchBarStyle.entry.contactWidth
+
+            entry: SipAddressesModel.getSipAddressObserver($sipAddress)
+          }
+
+          Column {
+            Layout.alignment: Qt.AlignVCenter
+            Layout.fillWidth: true
+
+            Text {
+              color: ChatSearchBarStyle.entry.time.color
+              font.pointSize: ChatSearchBarStyle.entry.time.pointSize
+              text: $timestamp.toLocaleString(
+                Qt.locale(App.locale),
+                Locale.ShortFormat
+              )
+              width: parent.width
+            }
+
+            Text {
+              color: ChatSearchBarStyle.entry.content.color
+              elide: Text.ElideRight
+              font.pointSize: ChatSearchBarStyle.entry.content.pointSize
+              text: $content
+              width: parent.width
+            }
+          }
+        }
+      }
+
+      // Separator.
+      Rectangle {
+        color: ChatSearchBarStyle.entry.separator.color
+        height: ChatSearchBarStyle.entry.separator.height
+        width: parent.width
+      }
+
+      // -----------------------------------------------------------------------
+
+      states: State {
+        when: mouseArea.containsMouse
+
+        PropertyChanges {
+          color: ChatSearchBarStyle.entry.color.hovered
+          target: hitEntry
+        }
+      }
+    }
+  }
+}
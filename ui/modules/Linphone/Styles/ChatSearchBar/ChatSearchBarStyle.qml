@@ -0,0 +1,36 @@
+pragma Singleton
+import QtQml 2.2
+
+import Colors 1.0
+import Units 1.0
+
+// =============================================================================
+
+QtObject {
+  property QtObject entry: QtObject {
+    property int contactWidth: 200
+    property int height: 50
+    property int rightMargin: 10
+    property int spacing: 10
+
+    property QtObject color: QtObject {
+      property color hovered: Colors.y
+      property color normal: Colors.k
+    }
+
+    property QtObject content: QtObject {
+      property color color: Colors.j
+      property int pointSize: Units.dp * 10
+    }
+
+    property QtObject separator: QtObject {
+      property color color: Colors.c
+      property int height: 1
+    }
+
+    property QtObject time: QtObject {
+      property color color: Colors.g
+      property int pointSize: Units.dp * 8
+    }
+  }
+}
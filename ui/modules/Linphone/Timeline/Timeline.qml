@@ -120,6 +120,8 @@ ColumnLayout {
           : TimelineStyle.contact.username.color.normal
 
         Loader {
+          id: tooltipLoader
+
           anchors.fill: parent
           sourceComponent: TooltipArea {
             text: $timelineEntry.timestamp.toLocaleString(
@@ -128,6 +130,14 @@ ColumnLayout {
             )
           }
         }
+
+        // Load the history of the hovered entry in advance.
+        Connections {
+          target: tooltipLoader.item
+          onContainsMouseChanged: tooltipLoader.item.containsMouse
+            ? view.model.prefetch(index)
+            : view.model.cancelPrefetch()
+        }
       }
 
       MouseArea {
@@ -19,6 +19,21 @@ function removeAllEntries () {
   })
 }
 
+function displayMessage (sipAddress, timestamp, content) {
+  if (sipAddress === conversation.sipAddress) {
+    chat.displayMessage(timestamp, content)
+    return
+  }
+
+  window.setView('Conversation', {
+    sipAddress: sipAddress,
+    messageToDisplay: {
+      timestamp: timestamp,
+      content: content
+    }
+  })
+}
+
 function getAvatar () {
   var contact = conversation._sipAddressObserver.contact
   return contact ? contact.vcard.avatar : ''
@@ -15,6 +15,9 @@ ColumnLayout  {
 
   property string sipAddress
 
+  // Message to display at the loading, given by the message search.
+  property var messageToDisplay
+
   readonly property var _sipAddressObserver: SipAddressesModel.getSipAddressObserver(sipAddress)
 
   // ---------------------------------------------------------------------------
@@ -135,6 +138,20 @@ ColumnLayout  {
 
       onClicked: Logic.updateChatFilter(button)
     }
+
+    ChatSearchBar {
+      anchors {
+        right: parent.right
+        rightMargin: ConversationStyle.filters.rightMargin
+        verticalCenter: parent.verticalCenter
+      }
+
+      maxMenuHeight: ConversationStyle.filters.searchBar.maxMenuHeight
+      placeholderText: qsTr('searchMessagesPlaceholder')
+      width: ConversationStyle.filters.searchBar.width
+
+      onHitClicked: Logic.displayMessage(sipAddress, timestamp, content)
+    }
   }
 
   // ---------------------------------------------------------------------------
@@ -142,9 +159,13 @@ ColumnLayout  {
   // ---------------------------------------------------------------------------
 
   Chat {
+    id: chat
+
     Layout.fillHeight: true
     Layout.fillWidth: true
 
+    initialMessage: conversation.messageToDisplay
+
     proxyModel: ChatProxyModel {
       id: chatProxyModel
 
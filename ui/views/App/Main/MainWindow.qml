@@ -60,6 +60,26 @@ ApplicationWindow {
 
   // ---------------------------------------------------------------------------
 
+  // Read only timeline of the last session, displayed until the core is started.
+  Loader {
+    active: !mainLoader.active
+    anchors.fill: parent
+
+    sourceComponent: Item {
+      Timeline {
+        anchors {
+          bottom: parent.bottom
+          left: parent.left
+          top: parent.top
+          topMargin: MainWindowStyle.toolBar.height
+        }
+
+        model: TimelineModel
+        width: MainWindowStyle.menu.width
+      }
+    }
+  }
+
   Loader {
     id: mainLoader
 
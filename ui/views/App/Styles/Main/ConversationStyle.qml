@@ -40,11 +40,17 @@ QtObject {
     property color backgroundColor: Colors.k
     property int height: 51
     property int leftMargin: 40
+    property int rightMargin: 30
 
     property QtObject border: QtObject {
       property color color: Colors.p
       property int bottomWidth: 1
       property int topWidth: 0
     }
+
+    property QtObject searchBar: QtObject {
+      property int maxMenuHeight: 300
+      property int width: 400
+    }
   }
 }